@@ -0,0 +1,40 @@
+/*
+    基准测试的公共部分
+    用法示例:
+        double ms = bench::Measure([&] { for (int i = 0; i < N; i++) del(i); });
+        bench::Report("Delegate::Invoke", ms);
+
+    其他:
+        1、bench 目录中的每个 .cpp 都是独立的程序，不需要构建系统，在 bench 目录中编译即可：
+               g++ -std=c++17 -O2 -pthread -I.. timer_wheel.cpp -o timer_wheel
+               cl /std:c++17 /O2 /EHsc /I.. timer_wheel.cpp
+        2、结果与机器和编译器有关，只用于同一台机器上不同实现之间的相对比较。
+        3、bench::sink 用于保存计算结果，防止编译器把被测的代码整个优化掉。
+*/
+#pragma once
+#include<chrono>
+#include<cstdio>
+#if defined(_MSC_VER)
+    #define BENCH_NOINLINE __declspec(noinline)
+#else
+    #define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+namespace bench
+{
+    inline volatile long long sink = 0;
+
+    //返回 fun 执行一次所用的毫秒数
+    template<class Fun>
+    double Measure(const Fun& fun)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        fun();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    inline void Report(const char* name, double ms)
+    {
+        std::printf("%-40s %10.1f ms\n", name, ms);
+    }
+}
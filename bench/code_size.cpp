@@ -0,0 +1,49 @@
+//代码体积：200 种不同签名的多播委托各自执行 Add、Invoke、Have、Sub、SubAllFor
+//这个程序本身只运行一次，需要比较的是编译结果的代码段大小，例如：
+//    g++ -std=c++17 -O2 -I.. code_size.cpp -o code_size && size code_size
+//在 delegate_core 引入之前和之后的版本上分别编译，比较 text 的大小
+#include<utility>
+#include"bench.hpp"
+#include"delegate.hpp"
+using namespace MyCodes;
+
+template<int I>
+struct Arg
+{
+    int v;
+};
+template<int I>
+struct Handler
+{
+    long n = 0;
+    void On(Arg<I> arg, int x)
+    {
+        n += arg.v + x;
+    }
+};
+
+template<int I>
+BENCH_NOINLINE long exercise()
+{
+    Delegate<void, Arg<I>, int> del;
+    Handler<I> a, b;
+    del.Add(a, &Handler<I>::On);
+    del.Add(b, &Handler<I>::On);
+    del(Arg<I>{ 1 }, 2);
+    const long have = del.Have(a, &Handler<I>::On);
+    del.Sub(a, &Handler<I>::On);
+    del.SubAllFor(&b);
+    return have + a.n + b.n + static_cast<long>(del.getsize());
+}
+
+template<int...I>
+long exerciseAll(std::integer_sequence<int, I...>)
+{
+    return (exercise<I>() + ...);
+}
+
+int main()
+{
+    bench::sink = exerciseAll(std::make_integer_sequence<int, 200>());
+    std::printf("%lld\n", static_cast<long long>(bench::sink));
+}
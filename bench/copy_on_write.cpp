@@ -0,0 +1,62 @@
+//写时复制：复制一个包含 24 个事件、每个事件 8 个订阅者的原型对象 10 万次
+#include"bench.hpp"
+#include"delegate.hpp"
+using namespace MyCodes;
+
+struct Subscriber
+{
+    long n = 0;
+    void On(int x)
+    {
+        n += x;
+    }
+};
+
+struct Prototype
+{
+    Delegate<void, int> events[24];
+};
+
+int main()
+{
+    Subscriber subs[8];
+    Subscriber extra;
+    for (int cow = 0; cow < 2; cow++)
+    {
+        Prototype proto;
+        for (auto& ev : proto.events)
+        {
+            ev.SetCopyOnWrite(cow != 0);
+            for (auto& sub : subs)
+                ev.Add(sub, &Subscriber::On);
+        }
+        size_t total = 0;
+        const double clone = bench::Measure([&]
+            {
+                for (int i = 0; i < 100000; i++)
+                {
+                    Prototype copy = proto;
+                    total += copy.events[3].getsize();
+                }
+            });
+        const double cloneAdd = bench::Measure([&]
+            {
+                for (int i = 0; i < 100000; i++)
+                {
+                    Prototype copy = proto;
+                    copy.events[i % 24].Add(extra, &Subscriber::On);
+                    total += copy.events[3].getsize();
+                }
+            });
+        const double invoke = bench::Measure([&]
+            {
+                for (int i = 0; i < 1000000; i++)
+                    proto.events[i % 24](1);
+            });
+        std::printf("%s\n", cow ? "copy-on-write" : "deep copy");
+        bench::Report("  clone", clone);
+        bench::Report("  clone + one Add", cloneAdd);
+        bench::Report("  1M Invoke", invoke);
+        bench::sink = static_cast<long long>(total);
+    }
+}
@@ -0,0 +1,52 @@
+//数据流图：200 层菱形依赖（每层 x -> l、r -> join），改变源节点后统计计算的次数和时间
+#include<memory>
+#include<vector>
+#include"bench.hpp"
+#include"delegate_dataflow.hpp"
+using namespace MyCodes;
+
+int main()
+{
+    constexpr int layers = 200;
+    DataflowGraph graph;
+    Source<long> source(graph, 0);
+    auto inc = [](const long& v) { return v + 1; };
+    auto dec = [](const long& v) { return v - 1; };
+    auto join = [](const long& l, const long& r) { return (l + r) / 2; };
+
+    std::vector<std::unique_ptr<DataflowNode<long>>> nodes;
+    DataflowNode<long>* last = &source;
+    for (int i = 0; i < layers; i++)
+    {
+        auto l = std::make_unique<Computed<long, long>>(graph, inc, *last);
+        auto r = std::make_unique<Computed<long, long>>(graph, dec, *last);
+        auto j = std::make_unique<Computed<long, long, long>>(graph, join, *l, *r);
+        last = j.get();
+        nodes.push_back(std::move(l));
+        nodes.push_back(std::move(r));
+        nodes.push_back(std::move(j));
+    }
+
+    graph.ResetCounters();
+    long value = 0;
+    const double ms = bench::Measure([&]
+        {
+            for (long i = 1; i <= 10000; i++)
+            {
+                source.Set(i);
+                graph.Flush();
+            }
+            value = last->Get();
+        });
+    bench::Report("10k changes through 200 diamonds", ms);
+    std::printf("evaluated %zu per change (%zu nodes), value %ld\n", graph.GetEvaluatedCount() / 10000, nodes.size(), value);
+
+    graph.ResetCounters();
+    source.Set(10000);
+    graph.Flush();
+    std::printf("setting an equal value evaluated %zu\n", graph.GetEvaluatedCount());
+
+    //按声明的相反顺序析构，依赖它的节点先析构
+    while (!nodes.empty())
+        nodes.pop_back();
+}
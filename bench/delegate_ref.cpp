@@ -0,0 +1,60 @@
+//回调参数：DelegateRef、std::function 和 DelegateSingle 作为遍历函数的参数
+//长遍历（1000 个元素）主要比较调用的开销，短遍历（4 个元素）主要比较每次构造回调的开销
+#include<vector>
+#include<functional>
+#include"bench.hpp"
+#include"delegate_ref.hpp"
+using namespace MyCodes;
+
+std::vector<int> values;
+
+BENCH_NOINLINE void visitRef(DelegateRef<void(int)> visit)
+{
+    for (int x : values)
+        visit(x);
+}
+BENCH_NOINLINE void visitFunction(const std::function<void(int)>& visit)
+{
+    for (int x : values)
+        visit(x);
+}
+BENCH_NOINLINE void visitDelegate(const DelegateSingle<void, int>& visit)
+{
+    for (int x : values)
+        visit(x);
+}
+
+void run(const char* title, size_t size)
+{
+    values.assign(size, 1);
+    long long total = 0;
+    long long extra = 3;
+    constexpr int rounds = 200000;
+    std::printf("%s\n", title);
+    bench::Report("  DelegateRef", bench::Measure([&]
+        {
+            for (int i = 0; i < rounds; i++)
+                visitRef([&](int x) { total += x; });
+        }));
+    bench::Report("  std::function (capture on the heap)", bench::Measure([&]
+        {
+            //捕获 3 个指针，超过 libstdc++ 中 std::function 内部缓冲区的大小，需要分配内存
+            for (int i = 0; i < rounds; i++)
+                visitFunction([&, p = &extra, q = &extra](int x) { total += x + *p - *q; });
+        }));
+    bench::Report("  DelegateSingle", bench::Measure([&]
+        {
+            for (int i = 0; i < rounds; i++)
+            {
+                auto lam = [&](int x) { total += x; };
+                visitDelegate(lam);
+            }
+        }));
+    bench::sink = total;
+}
+
+int main()
+{
+    run("1000-element visit", 1000);
+    run("4-element visit, callback built per call", 4);
+}
@@ -0,0 +1,63 @@
+//5 级的 long -> long 流水线运行 2000 万次：嵌套调用 DelegateSingle、Pipeline、StaticPipeline
+#include"bench.hpp"
+#include"delegate_pipeline.hpp"
+using namespace MyCodes;
+
+BENCH_NOINLINE long stage1(const long& x) { return x + 1; }
+BENCH_NOINLINE long stage2(const long& x) { return x * 3; }
+BENCH_NOINLINE long stage3(const long& x) { return x ^ 0x55; }
+BENCH_NOINLINE long stage4(const long& x) { return x - 7; }
+BENCH_NOINLINE long stage5(const long& x) { return x >> 1; }
+
+using Stage = DelegateSingle<long, const long&>;
+using Static = StaticPipeline<&stage1, &stage2, &stage3, &stage4, &stage5>;
+
+BENCH_NOINLINE long runNested(const Stage (&stages)[5], long x)
+{
+    return stages[4](stages[3](stages[2](stages[1](stages[0](x)))));
+}
+BENCH_NOINLINE long runPipeline(const Pipeline<long>& pipeline, long x)
+{
+    return pipeline(x);
+}
+BENCH_NOINLINE long runStatic(long x)
+{
+    return Static::Invoke(x);
+}
+BENCH_NOINLINE long runStaticDelegate(const Stage& del, long x)
+{
+    return del(x);
+}
+
+int main()
+{
+    const Stage stages[5] = { &stage1, &stage2, &stage3, &stage4, &stage5 };
+    Pipeline<long> pipeline;
+    for (const Stage& stage : stages)
+        pipeline.Then(stage);
+    const Stage fused = Static::ToDelegate<long, const long&>();
+
+    constexpr long runs = 20000000;
+    long long total = 0;
+    bench::Report("nested DelegateSingle calls", bench::Measure([&]
+        {
+            for (long i = 0; i < runs; i++)
+                total += runNested(stages, i);
+        }));
+    bench::Report("Pipeline<long>", bench::Measure([&]
+        {
+            for (long i = 0; i < runs; i++)
+                total += runPipeline(pipeline, i);
+        }));
+    bench::Report("StaticPipeline::Invoke", bench::Measure([&]
+        {
+            for (long i = 0; i < runs; i++)
+                total += runStatic(i);
+        }));
+    bench::Report("StaticPipeline::ToDelegate", bench::Measure([&]
+        {
+            for (long i = 0; i < runs; i++)
+                total += runStaticDelegate(fused, i);
+        }));
+    bench::sink = total;
+}
@@ -0,0 +1,47 @@
+//TimerWheel：100 万个定时器（十分之一延迟最多 2000 万个刻度），取消其中三分之一，然后前进到全部到期
+#include<random>
+#include<vector>
+#include"bench.hpp"
+#include"delegate_timer_wheel.hpp"
+using namespace MyCodes;
+
+struct Timer
+{
+    long fired = 0;
+    void OnTimeout()
+    {
+        fired++;
+    }
+};
+
+int main()
+{
+    constexpr size_t count = 1000000;
+    constexpr uint64_t horizon = 20000000;
+    TimerWheel<> wheel;
+    wheel.Reserve(count);
+    std::vector<Timer> timers(count);
+    std::vector<TimerHandle> handles(count);
+    std::mt19937_64 rng(3);
+
+    const double schedule = bench::Measure([&]
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                const uint64_t delay = i % 10 == 0 ? rng() % horizon : rng() % 100000 + 1;
+                handles[i] = wheel.Schedule(delay, { timers[i], &Timer::OnTimeout });
+            }
+        });
+    const double cancel = bench::Measure([&]
+        {
+            for (size_t i = 0; i < count; i += 3)
+                wheel.Cancel(handles[i]);
+        });
+    size_t fired = 0;
+    const double advance = bench::Measure([&] { fired = wheel.Advance(horizon + 1); });
+
+    bench::Report("schedule 1M", schedule);
+    bench::Report("cancel 333k", cancel);
+    bench::Report("advance 20M ticks + expire", advance);
+    std::printf("fired %zu, pending %zu\n", fired, wheel.PendingCount());
+}
@@ -0,0 +1,39 @@
+//有序与无序模式的 Sub：1 万个订阅者，随机删除再添加 20 万次
+#include<random>
+#include<vector>
+#include"bench.hpp"
+#include"delegate.hpp"
+using namespace MyCodes;
+
+struct Subscriber
+{
+    long n = 0;
+    void On(int x)
+    {
+        n += x;
+    }
+};
+
+int main()
+{
+    std::vector<Subscriber> subs(10000);
+    for (int unordered = 0; unordered < 2; unordered++)
+    {
+        Delegate<void, int> del;
+        del.SetUnordered(unordered != 0);
+        for (auto& sub : subs)
+            del.Add(sub, &Subscriber::On);
+        std::mt19937 rng(1);
+        const double ms = bench::Measure([&]
+            {
+                for (int i = 0; i < 200000; i++)
+                {
+                    Subscriber& sub = subs[rng() % subs.size()];
+                    del.Sub(sub, &Subscriber::On);
+                    del.Add(sub, &Subscriber::On);
+                }
+            });
+        bench::Report(unordered ? "unordered Sub + Add" : "ordered Sub + Add", ms);
+        bench::sink = bench::sink + static_cast<long long>(del.getsize());
+    }
+}
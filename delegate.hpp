@@ -16,6 +16,9 @@
            存储一个委托。
         3、空类型仅作为强制类型转换时的中间类型，无实际意义。
         4、若意外调用了空委托，则会抛出 MyCodes::bad_invoke 类型的异常。
+           定义了 MYCODES_DELEGATE_NO_EXCEPTIONS 宏（或 _HAS_EXCEPTIONS 为 0、GCC/Clang 使用了
+           -fno-exceptions）时，抛出异常的路径会被完全去掉，调用空委托获取返回值会直接 std::abort()，
+           此时所有的 Invoke 都是 noexcept 的。
         5、如果要绑定的函数有重载版本，那么用类似 del += {v, &decltype(v)::push_back};
            的语法时，编译器无法推导出是哪个重载，此时应该用 Add 方法，即
            del.Add(v,&decltype(v)::push_back);  Sub 方法同理。
@@ -43,52 +46,362 @@
                 private:
                     Delegate<void> del;
                 };
+        8、c++17 及以上可以使用 InvokeOpt 方法，委托为空时返回 std::nullopt，否则返回
+           包含调用结果的 std::optional（返回引用的委托为 std::optional<std::reference_wrapper>，
+           返回 void 的委托为 bool）。该方法为 noexcept，只做一次判空，不会抛出 bad_invoke，
+           也不要求返回值类型可以默认构造；被调用的函数抛出的异常会导致 std::terminate。标准库支持 std::expected 时，还可以使用
+           InvokeExpected 方法，委托为空时返回 invoke_errc::null_delegate 。
+        9、BindResolved 在绑定时就确定虚函数的最终实现和 this 指针的调整，之后的调用不再
+           查询虚函数表，适用于绑定后对象的动态类型不会改变的情况。只在 GCC/Clang（Itanium ABI）
+           下有效，其他编译器中等同于 Bind。用 BindResolved 绑定的委托只与同样用 BindResolved
+           绑定、且对象和最终实现都相同的委托相等，删除时也需要用 BindResolved 构造的委托。
+        10、c++17 及以上可以用 BindFront 把前面的几个参数直接绑定到委托内部，不需要额外分配
+           内存，也不需要保证 lambda 的生命周期。绑定的参数（以及可调用对象）需要可以平凡复制，
+           总大小不超过 DelegateSingle::bind_front_size（16 字节），每个参数内部不能有填充字节
+           （委托按字节比较绑定的参数）。
+                例：
+                    void handler(Context* ctx, int id, int x);
+                    DelegateSingle<void,int> del;
+                    del.BindFront<&handler>(ctx, 7);      //调用 del(x) 相当于 handler(ctx, 7, x)
+                    del.BindFront<&Obj::OnValue>(&obj, 7);//绑定类成员函数时第一个参数为对象指针
+                    del.BindFront(fp, ctx);               //可调用对象本身也可以在运行时传入
+           两个 BindFront 委托只有在目标和绑定的参数都相同时才相等，与普通方式绑定的委托不相等。
+           a.Then(b) 返回先调用 a、再把返回值传给 b 的委托（使用 BindFront 实现），只保存 a 和 b 的地址，
+           需要保证两者的生命周期，a 或 b 为临时对象（包括 Then 返回的临时委托）时编译失败；多级的
+           连接请使用 delegate_pipeline.hpp 中的 Pipeline 或 StaticPipeline。
+        11、定义了 MYCODES_DELEGATE_STATS 宏时，每个多播委托在构造时都会登记到一个全局的侵入式
+           链表中（不额外分配内存），可以通过 delegate_stats.hpp 中的 DelegateStats 查看所有委托
+           的数量、订阅者数量和预留容量等信息。未定义该宏时没有任何额外开销。
+        12、对象销毁时可以用 SubAllFor(&obj) 一次删除多播委托中所有绑定到该对象上的委托（包括
+           lambda 对象本身），只遍历一次数组；SubAll 删除所有与参数相等的委托；AddRange 一次预留
+           空间后添加一组委托。静态函数、BindFront 和排队的委托没有绑定对象，不会被 SubAllFor 删除。
+                例：
+                    Obj::~Obj()
+                    {
+                        onDamage.SubAllFor(this);
+                    }
+        13、调用顺序无关紧要的多播委托可以调用 SetUnordered(true) 切换为无序模式，此时 Sub 找到
+           委托后用最后一个委托填补空位，删除本身是 O(1) 的，不再移动后面的委托。无序模式下不保证
+           调用顺序与添加顺序一致；在调用过程中删除前面的委托时，被移到空位的委托在本次调用中
+           会被跳过。
+        14、所有 DelegateSingle 的内存布局都相同（delegate_slot），多播委托的存储、查找、删除和比较
+           都由与签名无关的 delegate_core 完成，每种签名只生成调用部分的代码，大量不同签名的委托
+           不会使代码体积成倍增长。Delegate 的 GetArray 返回的是 delegate_array，提供与 const
+           std::vector 相同的只读接口（size、data、operator[]、at、front、back、begin/end、
+           rbegin/rend 等），Delegate_anyRet 仍然使用 std::vector。
+        15、需要大量复制的 Delegate（例如作为原型对象的成员，克隆时整体复制）可以调用
+           SetCopyOnWrite(true)，之后复制得到的委托与原委托共享同一个订阅者数组，只增加一次引用
+           计数；任何一方 Add、Sub 时才复制出自己的数组。复制得到的委托同样开启写时复制。
+           因为数组被共享时 Sub、SubAll、SubAllFor 也需要分配内存，这些方法不是 noexcept 的。
+           调用时仍然直接遍历数组，没有额外开销。引用计数是原子的，共享数组的委托可以分别在
+           不同的线程中使用，但同一个委托对象本身仍然不是线程安全的。
+        16、MSVC 下用 _MSVC_LANG 判断c++语言版本，GCC/Clang 下用 __cplusplus，也可以在包含头文件前
+           自行定义 MYCODES_DELEGATE_LANG。Itanium ABI 下所有成员函数指针的格式相同，不需要区分
+           vbptr 和多继承，Bind 总是按普通的类成员函数绑定；MSVC 的 size 属性在其他编译器中不存在，
+           请使用 getsize()。
 */
 #pragma once
 #include<vector>
+#include<iterator>
+#include<algorithm>
+#include<cstdlib>
+#include<cstddef>
+#include<cstdint>
+#include<cstring>
+#include<type_traits>
 #include<exception>
+#include<stdexcept>
+#include<new>
+#include<atomic>
+#if defined(_MSC_VER)
 #pragma warning(disable:6011)	
 #pragma warning(disable:6101)   //让编译器不要发出空指针警告和未初始化_Out_参数警告
-#if _MSVC_LANG < 201402L
+#endif
+#if !defined(MYCODES_DELEGATE_LANG)    //当前项目的c++语言版本，MSVC 的 __cplusplus 默认总是 199711L
+    #if defined(_MSVC_LANG)
+        #define MYCODES_DELEGATE_LANG _MSVC_LANG
+    #else
+        #define MYCODES_DELEGATE_LANG __cplusplus
+    #endif
+#endif
+#if MYCODES_DELEGATE_LANG < 201402L
 #error(delegate.hpp：请使用c++14及以上的版本)
 #endif
-#if _MSVC_LANG > 201703L    //判断当前项目c++语言版本是否支持c++20
+#if MYCODES_DELEGATE_LANG > 201703L    //判断当前项目c++语言版本是否支持c++20
     #define mycodes_delegate_cpp20 1
 #else
     #define mycodes_delegate_cpp20 0
 #endif
+#if defined(__GNUC__) && !defined(_MSC_VER)    //Itanium ABI 下可以在绑定时解析虚函数
+    #define mycodes_delegate_resolve 1
+#else
+    #define mycodes_delegate_resolve 0
+#endif
+#if defined(MYCODES_DELEGATE_STATS)    //统计所有多播委托的内存占用（见 delegate_stats.hpp）
+    #define mycodes_delegate_stats 1
+    #include<mutex>
+    #include<typeinfo>
+#else
+    #define mycodes_delegate_stats 0
+#endif
+#if defined(MYCODES_DELEGATE_NO_EXCEPTIONS) || (defined(_HAS_EXCEPTIONS) && _HAS_EXCEPTIONS == 0) || \
+    (!defined(_MSC_VER) && !defined(__cpp_exceptions))      //GCC/Clang 的 -fno-exceptions
+    #define mycodes_delegate_noexcept 1     //去掉抛出 bad_invoke 的路径
+#else
+    #define mycodes_delegate_noexcept 0
+#endif
 
 #pragma push_macro("IF_CONSTEXPR")
 #undef IF_CONSTEXPR
 #pragma push_macro("CONSTEXPR")
 #undef CONSTEXPR
 
-#if _MSVC_LANG > 201402L    //判断当前项目c++语言版本是否支持c++17
+#if mycodes_delegate_cpp20
+    #include<version>
+#endif
+#if defined(__cpp_lib_expected)
+    #define mycodes_delegate_expected 1
+    #include<expected>
+#else
+    #define mycodes_delegate_expected 0
+#endif
+
+#if MYCODES_DELEGATE_LANG > 201402L    //判断当前项目c++语言版本是否支持c++17
     #define mycodes_delegate_cpp17 1
     #define IF_CONSTEXPR if constexpr
     #define CONSTEXPR constexpr
+    #include<optional>
+    #include<functional>
 #else
     #define mycodes_delegate_cpp17 0
     #define IF_CONSTEXPR if
     #define CONSTEXPR const
 #endif
 
+#if !defined(_MSC_VER)    //其他编译器没有 SAL 注解
+    #pragma push_macro("_In_")
+    #pragma push_macro("_Out_")
+    #undef _In_
+    #undef _Out_
+    #define _In_
+    #define _Out_
+#endif
+
 namespace MyCodes
 {//定义了一些下面通用的东西
     class bad_invoke :public std::exception
     {
     public:
-        bad_invoke():std::exception("试图调用空委托获得返回值")
+        bad_invoke() = default;
+        const char* what()const noexcept override
         {
-
+            return "试图调用空委托获得返回值";
         }
     };
 
     enum class CallType //单个委托的调用方式
     {
-        null, this_call, static_call, vbptr_this_call, multiple_this_call
+        null, this_call, static_call, vbptr_this_call, multiple_this_call, resolved_call, bound_call
+    };
+
+    [[noreturn]] inline void throwBadInvoke()
+    {
+    #if mycodes_delegate_noexcept
+        std::abort();
+    #else
+        throw bad_invoke();
+    #endif
+    }
+
+#if mycodes_delegate_cpp17
+    //InvokeOpt 的返回类型，引用用 reference_wrapper 包装，void 用 bool 表示是否调用成功
+    template<class Ty_ret>
+    struct invoke_opt
+    {
+        using type = std::optional<Ty_ret>;
+    };
+    template<class Ty_ret>
+    struct invoke_opt<Ty_ret&>
+    {
+        using type = std::optional<std::reference_wrapper<Ty_ret>>;
+    };
+    template<>
+    struct invoke_opt<void>
+    {
+        using type = bool;
+    };
+    template<class Ty_ret>
+    using invoke_opt_t = typename invoke_opt<Ty_ret>::type;
+
+    //把一个绑定的参数按字节复制到已清零的存储中，不写入填充字节，按字节比较时才可靠
+    template<class Ty>
+    inline void storeFrontArg(unsigned char* dest, const Ty& value)noexcept
+    {
+        static_assert(std::is_empty_v<Ty> || std::is_scalar_v<Ty> || std::has_unique_object_representations_v<Ty>,
+            "BindFront：绑定的参数内部有填充字节，无法按字节比较");
+        if constexpr (!std::is_empty_v<Ty>)
+            std::memcpy(dest, &value, sizeof(Ty));
+    }
+
+    //BindFront 在委托内部存储的参数，是可以平凡复制的聚合体
+    template<class...Ty_bound>
+    struct front_args
+    {
+        template<class Fun, class...Ty_prev>
+        decltype(auto) call(const Fun& fun, const Ty_prev&... prev)const
+        {
+            return fun(prev...);
+        }
+        void store(unsigned char*)const noexcept
+        {
+        }
+    };
+    template<class Ty_first>
+    struct front_args<Ty_first>
+    {
+        Ty_first first;
+
+        template<class Fun, class...Ty_prev>
+        decltype(auto) call(const Fun& fun, const Ty_prev&... prev)const
+        {
+            return fun(prev..., first);
+        }
+        //逐个成员复制到 dest 中对应的位置
+        void store(unsigned char* dest)const noexcept
+        {
+            storeFrontArg(dest + (reinterpret_cast<const unsigned char*>(&first) - reinterpret_cast<const unsigned char*>(this)), first);
+        }
+    };
+    template<class Ty_first, class Ty_second, class...Ty_bound>
+    struct front_args<Ty_first, Ty_second, Ty_bound...>
+    {
+        Ty_first first;
+        front_args<Ty_second, Ty_bound...> rest;
+
+        //按顺序展开所有绑定的参数后调用 fun
+        template<class Fun, class...Ty_prev>
+        decltype(auto) call(const Fun& fun, const Ty_prev&... prev)const
+        {
+            return rest.call(fun, prev..., first);
+        }
+        void store(unsigned char* dest)const noexcept
+        {
+            const unsigned char* base = reinterpret_cast<const unsigned char*>(this);
+            storeFrontArg(dest + (reinterpret_cast<const unsigned char*>(&first) - base), first);
+            rest.store(dest + (reinterpret_cast<const unsigned char*>(&rest) - base));
+        }
+    };
+#endif
+
+#if mycodes_delegate_expected
+    enum class invoke_errc
+    {
+        null_delegate   //委托为空
+    };
+
+    //InvokeExpected 的返回类型
+    template<class Ty_ret>
+    struct invoke_expected
+    {
+        using type = std::expected<Ty_ret, invoke_errc>;
+    };
+    template<class Ty_ret>
+    struct invoke_expected<Ty_ret&>
+    {
+        using type = std::expected<std::reference_wrapper<Ty_ret>, invoke_errc>;
+    };
+    template<class Ty_ret>
+    using invoke_expected_t = typename invoke_expected<Ty_ret>::type;
+#endif
+
+#if mycodes_delegate_stats
+    struct delegate_stats_entry //单个多播委托的统计信息
+    {
+        const void* address;
+        const char* signature;
+        size_t size;
+        size_t capacity;
+        size_t elem_size;
     };
 
+    //嵌入在多播委托中的侵入式链表节点
+    class delegate_stats_hook
+    {
+    public:
+        delegate_stats_hook() = default;
+        delegate_stats_hook(const delegate_stats_hook&)noexcept
+        {
+        }
+        delegate_stats_hook& operator=(const delegate_stats_hook&)noexcept
+        {
+            return *this;
+        }
+        ~delegate_stats_hook()
+        {
+            std::lock_guard<std::mutex> lock(mutex());
+            if (m_prev != nullptr)
+                m_prev->m_next = m_next;
+            if (m_next != nullptr)
+                m_next->m_prev = m_prev;
+            if (head() == this)
+                head() = m_next;
+        }
+
+        //登记到全局链表中，owner 为所在的多播委托
+        void Attach(const void* owner, const char* signature, size_t elemSize)
+        {
+            m_owner = owner;
+            m_signature = signature;
+            m_elemSize = elemSize;
+            std::lock_guard<std::mutex> lock(mutex());
+            m_next = head();
+            if (m_next != nullptr)
+                m_next->m_prev = this;
+            head() = this;
+        }
+
+        //多播委托的订阅者数组改变后调用，统计时只读取这两个副本，不访问委托本身
+        void Update(size_t size, size_t capacity)noexcept
+        {
+            m_size.store(size, std::memory_order_relaxed);
+            m_capacity.store(capacity, std::memory_order_relaxed);
+        }
+
+        //在持有全局锁的情况下遍历所有登记的多播委托
+        template<class Fun>
+        static void ForEach(const Fun& fun)
+        {
+            std::lock_guard<std::mutex> lock(mutex());
+            for (const delegate_stats_hook* node = head(); node != nullptr; node = node->m_next)
+            {
+                const delegate_stats_entry entry{ node->m_owner, node->m_signature,
+                    node->m_size.load(std::memory_order_relaxed), node->m_capacity.load(std::memory_order_relaxed), node->m_elemSize };
+                fun(entry);
+            }
+        }
+
+    protected:
+        static std::mutex& mutex()noexcept
+        {
+            static std::mutex _mutex;
+            return _mutex;
+        }
+        static delegate_stats_hook*& head()noexcept
+        {
+            static delegate_stats_hook* _head = nullptr;
+            return _head;
+        }
+
+        delegate_stats_hook* m_prev = nullptr;
+        delegate_stats_hook* m_next = nullptr;
+        const void* m_owner = nullptr;
+        const char* m_signature = "";
+        size_t m_elemSize = 0;
+        std::atomic<size_t> m_size{ 0 };
+        std::atomic<size_t> m_capacity{ 0 };
+    };
+#endif
+
     template<class DelType>
     inline bool subDelegate(const DelType& del, std::vector<DelType>& allDels)noexcept
     {//使用反向迭代器,把最后面的一个满足条件的委托移除
@@ -103,6 +416,22 @@ namespace MyCodes
         return false;
     }
 
+    template<class DelType>
+    inline bool subDelegate_unordered(const DelType& del, std::vector<DelType>& allDels)noexcept
+    {//找到最后面的一个满足条件的委托后，用最后一个委托填补它的位置，不移动其他委托
+        for (auto it = allDels.rbegin(); it != allDels.rend(); it++)
+        {
+            if (*it == del)
+            {
+                if (it != allDels.rbegin())
+                    *it = allDels.back();
+                allDels.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
     template<class DelType>
     inline bool haveDelegate(const DelType& del, const std::vector<DelType>& allDels)noexcept
     {
@@ -145,15 +474,18 @@ namespace MyCodes
     };
 
 #if mycodes_delegate_cpp20  
+    //Itanium ABI 下所有成员函数指针的大小相同，且本身就包含 this 指针的调整，不需要区分
+    constexpr bool pmf_size_varies = sizeof(void(Empty::*)()) != sizeof(void(Empty_multiple::*)());
+
     template<class T>
-    concept is_virtual_override = requires(void(T:: * fp)())
+    concept is_virtual_override = pmf_size_varies && requires(void(T:: * fp)())
     {
         //判断是否是带有vbptr的类
         reinterpret_cast<void(Empty_vbptr::*)()>(fp);
     };
 
     template<class T>
-    concept is_multiple_override = requires(void(T:: * fp)())
+    concept is_multiple_override = pmf_size_varies && requires(void(T:: * fp)())
     {
         //判断是否是多继承的类
         reinterpret_cast<void(Empty_multiple::*)()>(fp);
@@ -169,18 +501,485 @@ namespace MyCodes
     template<class Lambda, class...Ty_params>
     concept is_lambda_any = requires(Lambda lam, Ty_params... params)
     {
-        //判断是否是特定参数的可调用对象
-        lam(params...);
-    };
-#endif
-}
+        //判断是否是特定参数的可调用对象
+        lam(params...);
+    };
+#endif
+}
+
+namespace MyCodes
+{
+    struct delegate_slot //所有 DelegateSingle 共同的内存布局，与签名无关
+    {
+        CallType _call_type;
+        union
+        {
+            void* value;
+            void(*bound_fun)();
+        } _this;
+        union
+        {
+            void* value;
+            void(Empty::* this_fun)();
+            void(*static_fun)();
+            void* dvalue[2];
+            void(Empty_vbptr::* _this_fun_vbptr)();
+            void(Empty_multiple::* _this_fun_multiple)();
+        } _fun;
+    };
+
+    //与签名无关的公共部分：存储的增长、查找、删除和比较都在这里完成，
+    //每种签名只保留很薄的一层类型转换和调用代码
+    class delegate_core
+    {
+    public:
+        static bool Equal(const delegate_slot& left, const delegate_slot& right)noexcept
+        {
+            if (left._call_type != right._call_type)
+                return false;
+            switch (left._call_type)
+            {
+            case CallType::static_call:
+                return left._fun.static_fun == right._fun.static_fun;
+            case CallType::this_call:
+                return left._this.value == right._this.value &&
+                    left._fun.this_fun == right._fun.this_fun;
+            case CallType::vbptr_this_call:
+                return left._this.value == right._this.value &&
+                    left._fun._this_fun_vbptr == right._fun._this_fun_vbptr;
+            case CallType::multiple_this_call:
+                return left._this.value == right._this.value &&
+                    left._fun._this_fun_multiple == right._fun._this_fun_multiple;
+            case CallType::resolved_call:
+                return left._this.value == right._this.value &&
+                    left._fun.value == right._fun.value;
+            case CallType::bound_call:
+                return left._this.bound_fun == right._this.bound_fun &&
+                    std::memcmp(&left._fun, &right._fun, sizeof(left._fun)) == 0;
+            case CallType::null:
+                return true;
+            default:
+                return false;
+            }
+        }
+        //绑定的对象地址，静态函数和 BindFront 绑定的委托返回 nullptr
+        static const void* Target(const delegate_slot& del)noexcept
+        {
+            switch (del._call_type)
+            {
+            case CallType::this_call:
+            case CallType::vbptr_this_call:
+            case CallType::multiple_this_call:
+                return del._this.value;
+            case CallType::resolved_call:
+                return del._fun.dvalue[1];
+            default:
+                return nullptr;
+            }
+        }
+
+        //从后向前查找，找不到时返回 count
+        static size_t FindLast(const delegate_slot* dels, size_t count, const delegate_slot& del)noexcept
+        {
+            for (size_t i = count; i > 0; i--)
+            {
+                if (Equal(dels[i - 1], del))
+                    return i - 1;
+            }
+            return count;
+        }
+        //查找第一个绑定到 target 对象上的委托，找不到时返回 count
+        static size_t FindTarget(const delegate_slot* dels, size_t count, const void* target)noexcept
+        {
+            for (size_t i = 0; target != nullptr && i < count; i++)
+            {
+                if (Target(dels[i]) == target)
+                    return i;
+            }
+            return count;
+        }
+        //删除 [first, last)，返回新的数量
+        static size_t Erase(delegate_slot* dels, size_t count, size_t first, size_t last)noexcept
+        {
+            std::memmove(dels + first, dels + last, (count - last) * sizeof(delegate_slot));
+            return count - (last - first);
+        }
+        //删除所有与 del 相等的委托，返回新的数量
+        static size_t RemoveEqual(delegate_slot* dels, size_t count, const delegate_slot& del)noexcept
+        {
+            size_t kept = 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                if (!Equal(dels[i], del))
+                    dels[kept++] = dels[i];
+            }
+            return kept;
+        }
+        //删除所有绑定到 target 对象上的委托，返回新的数量
+        static size_t RemoveTarget(delegate_slot* dels, size_t count, const void* target)noexcept
+        {
+            size_t kept = 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                if (target == nullptr || Target(dels[i]) != target)
+                    dels[kept++] = dels[i];
+            }
+            return kept;
+        }
+        //存储块的头部在委托数组之前，引用计数大于 1 时多个委托数组共享同一个存储块（写时复制）
+        struct block_header
+        {
+            std::atomic<size_t> refs;
+            size_t capacity;
+        };
+        static_assert(sizeof(block_header) % alignof(delegate_slot) == 0, "delegate_core：存储块头部的大小不是委托对齐的整数倍");
+
+        static block_header* Header(const delegate_slot* dels)noexcept
+        {
+            return reinterpret_cast<block_header*>(const_cast<delegate_slot*>(dels)) - 1;
+        }
+        static delegate_slot* Allocate(size_t capacity)
+        {
+            void* data = std::malloc(sizeof(block_header) + capacity * sizeof(delegate_slot));
+            if (data == nullptr)
+            {
+            #if mycodes_delegate_noexcept
+                std::abort();
+            #else
+                throw std::bad_alloc();
+            #endif
+            }
+            block_header* header = ::new(data) block_header;
+            header->refs.store(1, std::memory_order_relaxed);
+            header->capacity = capacity;
+            return reinterpret_cast<delegate_slot*>(header + 1);
+        }
+        static void Release(delegate_slot* dels)noexcept
+        {
+            if (dels == nullptr)
+                return;
+            block_header* header = Header(dels);
+            if (header->refs.load(std::memory_order_acquire) == 1 ||
+                header->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                header->~block_header();
+                std::free(header);
+            }
+        }
+        static delegate_slot* Share(delegate_slot* dels)noexcept
+        {
+            if (dels != nullptr)
+                Header(dels)->refs.fetch_add(1, std::memory_order_relaxed);
+            return dels;
+        }
+        static bool Shared(const delegate_slot* dels)noexcept
+        {
+            return dels != nullptr && Header(dels)->refs.load(std::memory_order_acquire) != 1;
+        }
+        static size_t Capacity(const delegate_slot* dels)noexcept
+        {
+            return dels == nullptr ? 0 : Header(dels)->capacity;
+        }
+        //复制前 count 个委托到容量为 capacity 的新存储块中，并释放原来的存储块
+        static delegate_slot* Reallocate(delegate_slot* dels, size_t count, size_t capacity)
+        {
+            delegate_slot* data = Allocate(capacity);
+            if (count != 0)
+                std::memcpy(data, dels, count * sizeof(delegate_slot));
+            Release(dels);
+            return data;
+        }
+        //把容量扩大到至少 need，返回新的存储块
+        static delegate_slot* Grow(delegate_slot* dels, size_t count, size_t need)
+        {
+            const size_t capacity = Capacity(dels);
+            size_t newCapacity = capacity < 2 ? 4 : capacity * 2;
+            if (newCapacity < need)
+                newCapacity = need;
+            return Reallocate(dels, count, newCapacity);
+        }
+    };
+
+    //布局与 DelegateSingle 相同、可以平凡复制的委托才能使用 delegate_core
+    template<class DelType>
+    struct is_delegate_slot :std::integral_constant<bool,
+        std::is_trivially_copyable<DelType>::value && sizeof(DelType) == sizeof(delegate_slot) &&
+        alignof(DelType) == alignof(delegate_slot)>
+    {
+    };
+
+    template<class DelType>
+    class delegate_array //委托数组，只做类型转换，实际的操作都由 delegate_core 完成
+    {
+        static_assert(is_delegate_slot<DelType>::value, "delegate_array：委托的布局与 delegate_slot 不同");
+    public:
+        using value_type = DelType;
+        using size_type = size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference = const DelType&;
+        using const_reference = const DelType&;
+        using pointer = const DelType*;
+        using const_pointer = const DelType*;
+        using iterator = DelType*;
+        using const_iterator = const DelType*;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        delegate_array() = default;
+        //开启了写时复制时与 right 共享存储块，否则复制所有委托
+        delegate_array(const delegate_array& right)
+            :m_size(right.m_size), m_copyOnWrite(right.m_copyOnWrite)
+        {
+            if (m_copyOnWrite)
+                m_data = delegate_core::Share(right.m_data);
+            else if (m_size != 0)
+            {
+                m_data = delegate_core::Allocate(m_size);
+                std::memcpy(m_data, right.m_data, m_size * sizeof(delegate_slot));
+            }
+        }
+        delegate_array(delegate_array&& right)noexcept
+            :m_data(right.m_data), m_size(right.m_size), m_copyOnWrite(right.m_copyOnWrite)
+        {
+            right.m_data = nullptr;
+            right.m_size = 0;
+        }
+        delegate_array& operator=(delegate_array right)noexcept
+        {
+            swap(right);
+            return *this;
+        }
+        ~delegate_array()
+        {
+            delegate_core::Release(m_data);
+        }
+
+        void push_back(const DelType& del)
+        {
+            if (m_size == capacity())
+                m_data = delegate_core::Grow(m_data, m_size, m_size + 1);
+            else if (delegate_core::Shared(m_data))     //只是为了与其他委托分开，按原来的容量复制
+                m_data = delegate_core::Reallocate(m_data, m_size, capacity());
+            std::memcpy(static_cast<void*>(m_data + m_size), &del, sizeof(delegate_slot));
+            m_size++;
+        }
+        void pop_back()noexcept
+        {
+            m_size--;
+        }
+        void reserve(size_t capacity)
+        {
+            if (capacity > this->capacity())
+                m_data = delegate_core::Reallocate(m_data, m_size, capacity);
+        }
+        void clear()noexcept
+        {
+            if (delegate_core::Shared(m_data))
+            {
+                delegate_core::Release(m_data);
+                m_data = nullptr;
+            }
+            m_size = 0;
+        }
+        iterator erase(const_iterator first, const_iterator last)
+        {
+            const size_t index = static_cast<size_t>(first - begin());
+            m_size = delegate_core::Erase(mutable_slots(), m_size, index, static_cast<size_t>(last - begin()));
+            return begin() + index;
+        }
+        void swap(delegate_array& right)noexcept
+        {
+            std::swap(m_data, right.m_data);
+            std::swap(m_size, right.m_size);
+            std::swap(m_copyOnWrite, right.m_copyOnWrite);
+        }
+        //开启后复制委托数组时只增加引用计数，修改时才复制
+        void set_copy_on_write(bool on)noexcept
+        {
+            m_copyOnWrite = on;
+        }
+        bool copy_on_write()const noexcept
+        {
+            return m_copyOnWrite;
+        }
+        bool shared()const noexcept
+        {
+            return delegate_core::Shared(m_data);
+        }
+
+        size_t size()const noexcept
+        {
+            return m_size;
+        }
+        size_t capacity()const noexcept
+        {
+            return delegate_core::Capacity(m_data);
+        }
+        bool empty()const noexcept
+        {
+            return m_size == 0;
+        }
+        //与 const std::vector 相同的只读访问，修改需要通过 Delegate 的方法
+        const DelType* data()const noexcept
+        {
+            return reinterpret_cast<const DelType*>(m_data);
+        }
+        const DelType& operator[](size_t index)const noexcept
+        {
+            return data()[index];
+        }
+        const DelType& at(size_t index)const
+        {
+            if (index >= m_size)
+            {
+            #if mycodes_delegate_noexcept
+                std::abort();
+            #else
+                throw std::out_of_range("delegate_array::at：下标越界");
+            #endif
+            }
+            return data()[index];
+        }
+        const DelType& front()const noexcept
+        {
+            return data()[0];
+        }
+        const DelType& back()const noexcept
+        {
+            return data()[m_size - 1];
+        }
+        const_iterator begin()const noexcept
+        {
+            return data();
+        }
+        const_iterator end()const noexcept
+        {
+            return data() + m_size;
+        }
+        const_iterator cbegin()const noexcept
+        {
+            return begin();
+        }
+        const_iterator cend()const noexcept
+        {
+            return end();
+        }
+        const_reverse_iterator rbegin()const noexcept
+        {
+            return const_reverse_iterator(end());
+        }
+        const_reverse_iterator rend()const noexcept
+        {
+            return const_reverse_iterator(begin());
+        }
+        const_reverse_iterator crbegin()const noexcept
+        {
+            return rbegin();
+        }
+        const_reverse_iterator crend()const noexcept
+        {
+            return rend();
+        }
+
+        //以下由 subDelegate 等函数使用
+        const delegate_slot* slots()const noexcept
+        {
+            return m_data;
+        }
+        //需要修改存储块时调用，存储块被共享时先复制一份
+        delegate_slot* mutable_slots()
+        {
+            if (delegate_core::Shared(m_data))
+                m_data = delegate_core::Reallocate(m_data, m_size, capacity());
+            return m_data;
+        }
+        void resize_down(size_t size)noexcept
+        {
+            m_size = size;
+        }
+
+    protected:
+        delegate_slot* m_data = nullptr;
+        size_t m_size = 0;
+        bool m_copyOnWrite = false;
+    };
+
+    //下面的函数都按字节复制出要查找的委托再比较，直接以 delegate_slot 读取 DelType 会违反严格别名规则
+    template<class DelType>
+    inline bool subDelegate(const DelType& del, delegate_array<DelType>& allDels)
+    {
+        delegate_slot slot;
+        std::memcpy(&slot, &del, sizeof(delegate_slot));
+        const size_t index = delegate_core::FindLast(allDels.slots(), allDels.size(), slot);
+        if (index == allDels.size())
+            return false;
+        allDels.resize_down(delegate_core::Erase(allDels.mutable_slots(), allDels.size(), index, index + 1));
+        return true;
+    }
+    template<class DelType>
+    inline bool subDelegate_unordered(const DelType& del, delegate_array<DelType>& allDels)
+    {
+        delegate_slot slot;
+        std::memcpy(&slot, &del, sizeof(delegate_slot));
+        const size_t index = delegate_core::FindLast(allDels.slots(), allDels.size(), slot);
+        if (index == allDels.size())
+            return false;
+        delegate_slot* dels = allDels.mutable_slots();
+        dels[index] = dels[allDels.size() - 1];
+        allDels.pop_back();
+        return true;
+    }
+    template<class DelType>
+    inline bool haveDelegate(const DelType& del, const delegate_array<DelType>& allDels)noexcept
+    {
+        delegate_slot slot;
+        std::memcpy(&slot, &del, sizeof(delegate_slot));
+        return delegate_core::FindLast(allDels.slots(), allDels.size(), slot) != allDels.size();
+    }
+    template<class DelType>
+    inline size_t subAllDelegate(const DelType& del, delegate_array<DelType>& allDels)
+    {
+        delegate_slot slot;
+        std::memcpy(&slot, &del, sizeof(delegate_slot));
+        const size_t count = allDels.size();
+        if (delegate_core::FindLast(allDels.slots(), count, slot) == count)
+            return 0;
+        allDels.resize_down(delegate_core::RemoveEqual(allDels.mutable_slots(), count, slot));
+        return count - allDels.size();
+    }
+    template<class DelType>
+    inline size_t subTargetDelegate(const void* target, delegate_array<DelType>& allDels)
+    {
+        const size_t count = allDels.size();
+        if (delegate_core::FindTarget(allDels.slots(), count, target) == count)
+            return 0;
+        allDels.resize_down(delegate_core::RemoveTarget(allDels.mutable_slots(), count, target));
+        return count - allDels.size();
+    }
+    template<class DelType>
+    inline size_t subAllDelegate(const DelType& del, std::vector<DelType>& allDels)noexcept
+    {
+        auto it = std::remove_if(allDels.begin(), allDels.end(),
+            [&del](const DelType& item) { return item == del; });
+        const size_t count = static_cast<size_t>(allDels.end() - it);
+        allDels.erase(it, allDels.end());
+        return count;
+    }
+    template<class DelType>
+    inline size_t subTargetDelegate(const void* target, std::vector<DelType>& allDels)noexcept
+    {
+        if (target == nullptr)
+            return 0;
+        auto it = std::remove_if(allDels.begin(), allDels.end(),
+            [target](const DelType& item) { return item.GetTarget() == target; });
+        const size_t count = static_cast<size_t>(allDels.end() - it);
+        allDels.erase(it, allDels.end());
+        return count;
+    }
 
-namespace MyCodes
-{
     template<class Ty_ret, class... Ty_params>
     class DelegateSingle	//单委托
     {
-        template<class, class...Ty_params>
+        template<class, class...>
         friend class DelegateSingle_any;
     public:
         DelegateSingle() = default;
@@ -289,7 +1088,7 @@ namespace MyCodes
         template<class CLS>
         void Bind(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...))noexcept
         {
-            IF_CONSTEXPR(sizeof(__fun) == sizeof(void*))
+            IF_CONSTEXPR(sizeof(__fun) == sizeof(void(Empty::*)()))    //Itanium ABI 下总是成立
             {
                 _call_type = CallType::this_call;
                 _this._ptr = reinterpret_cast<decltype(_this._ptr)>(const_cast<CLS*>(&__this));
@@ -306,7 +1105,7 @@ namespace MyCodes
         template<class CLS>
         void Bind(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)noexcept
         {
-            IF_CONSTEXPR(sizeof(__fun) == sizeof(void*))
+            IF_CONSTEXPR(sizeof(__fun) == sizeof(void(Empty::*)()))    //Itanium ABI 下总是成立
             {
                 _call_type = CallType::this_call;
                 _this._ptr = reinterpret_cast<decltype(_this._ptr)>(const_cast<CLS*>(&__this));
@@ -360,7 +1159,7 @@ namespace MyCodes
         void Bind(const Lambda& lam)
         {
             #if mycodes_delegate_cpp17
-            IF_CONSTEXPR(std::is_empty_v<Lambda>)
+            IF_CONSTEXPR(std::is_empty<Lambda>::value)
             {
                 this->Bind(static_cast<Ty_ret(*)(Ty_params...)>(lam));
             }
@@ -372,10 +1171,74 @@ namespace MyCodes
         }
 #endif
 
+        //绑定时解析虚函数，之后的调用直接调用最终实现
+        template<class CLS>
+        void BindResolved(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...))noexcept
+        {
+            this->bindResolved(__this, __fun);
+        }
+        template<class CLS>
+        void BindResolved(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)noexcept
+        {
+            this->bindResolved(__this, __fun);
+        }
+
+#if mycodes_delegate_cpp17
+        static constexpr size_t bind_front_size = 2 * sizeof(void*);
+
+        //绑定函数或类成员函数 Fun 以及前面的几个参数
+        template<auto Fun, class...Ty_bound>
+        void BindFront(const Ty_bound&... bound)noexcept
+        {
+            using Bound = front_args<Ty_bound...>;
+            this->bindFront<Bound>(&frontThunk<Bound, Fun>, Bound{ bound... });
+        }
+        //绑定可调用对象以及前面的几个参数，可调用对象也存储在委托内部
+        template<class Callable, class...Ty_bound>
+        void BindFront(const Callable& fun, const Ty_bound&... bound)noexcept
+        {
+            using Bound = front_args<Callable, Ty_bound...>;
+            this->bindFront<Bound>(&frontThunk_callable<Bound>, Bound{ fun, bound... });
+        }
+
+        //返回先调用自身、再把返回值传给 next 的委托，内部只保存两个委托的地址
+        template<class Ty_next, class Ty_value>
+        DelegateSingle<Ty_next, Ty_params...> Then(const DelegateSingle<Ty_next, const Ty_value&>& next)const& noexcept
+        {
+            static_assert(!std::is_void_v<Ty_ret> && std::is_convertible_v<Ty_ret, const Ty_value&>,
+                "Then：返回值不能作为 next 的参数");
+            struct Stage
+            {
+                const DelegateSingle* first;
+                const DelegateSingle<Ty_next, const Ty_value&>* next;
+
+                Ty_next operator()(const Ty_params&... params)const
+                {
+                    return next->Invoke(first->Invoke(params...));
+                }
+            };
+            DelegateSingle<Ty_next, Ty_params...> del;
+            del.BindFront(Stage{ this, &next });
+            return del;
+        }
+        //临时的委托会在返回后销毁，不能用于 Then
+        template<class Ty_next, class Ty_value>
+        DelegateSingle<Ty_next, Ty_params...> Then(DelegateSingle<Ty_next, const Ty_value&>&& next)const& = delete;
+        template<class Ty_next, class Ty_value>
+        DelegateSingle<Ty_next, Ty_params...> Then(const DelegateSingle<Ty_next, const Ty_value&>& next)const&& = delete;
+        template<class Ty_next, class Ty_value>
+        DelegateSingle<Ty_next, Ty_params...> Then(DelegateSingle<Ty_next, const Ty_value&>&& next)const&& = delete;
+#endif
+
         bool IsNull()const noexcept
         {
             return _call_type == CallType::null;
         }
+        //绑定的对象地址，静态函数和 BindFront 绑定的委托返回 nullptr
+        const void* GetTarget()const noexcept
+        {
+            return delegate_core::Target(slotCopy());
+        }
         operator bool()const noexcept
         {
             return _call_type != CallType::null;
@@ -383,7 +1246,9 @@ namespace MyCodes
 
         //触发调用
         Ty_ret Invoke(const Ty_params&... params)const
-        #if mycodes_delegate_cpp17
+        #if mycodes_delegate_noexcept
+            noexcept
+        #elif mycodes_delegate_cpp17
             noexcept(std::is_void_v<Ty_ret>)    
         #endif
         {
@@ -409,6 +1274,16 @@ namespace MyCodes
                 return (_this._ptr_multiple->*(_fun._this_fun_multiple))(params...);
             }
             break;
+            case CallType::resolved_call:
+            {
+                return _fun.resolved_fun(_this.value, params...);
+            }
+            break;
+            case CallType::bound_call:
+            {
+                return _this.bound_fun(&_fun, params...);
+            }
+            break;
             default:
                 break;
             }
@@ -417,18 +1292,20 @@ namespace MyCodes
             //如果委托不能调用
             if constexpr (!std::is_void_v<Ty_ret>)
             {
-                throw bad_invoke();
+                throwBadInvoke();
             }
             else
             {
                 return;
             }
             #else
-            throw bad_invoke();
+            throwBadInvoke();
             #endif
         }
         Ty_ret operator()(const Ty_params&... params)const 
-        #if mycodes_delegate_cpp17
+        #if mycodes_delegate_noexcept
+            noexcept
+        #elif mycodes_delegate_cpp17
             noexcept(std::is_void_v<Ty_ret>)
         #endif
         {
@@ -444,45 +1321,84 @@ namespace MyCodes
                 return true;
             }
         }
-
-        //解除绑定
-        void UnBind()noexcept
-        {
-            _this.value = nullptr;
-            _fun.dvalue[0] = nullptr;   _fun.dvalue[1] = nullptr;
-            _call_type = CallType::null;
-        }
-
-        bool operator==(const DelegateSingle& right)const noexcept
+        //不判空直接调用，调用前需保证委托不为空
+        Ty_ret InvokeUnchecked(const Ty_params&... params)const
+        #if mycodes_delegate_noexcept
+            noexcept
+        #elif mycodes_delegate_cpp17
+            noexcept(std::is_void_v<Ty_ret>)
+        #endif
         {
             switch (_call_type)
             {
             case CallType::static_call:
-                return this->_fun.static_fun == right._fun.static_fun;
+                return _fun.static_fun(params...);
             case CallType::this_call:
-                return this->_this.value == right._this.value &&
-                    this->_fun.this_fun == right._fun.this_fun;
+                return (_this._ptr->*(_fun.this_fun))(params...);
             case CallType::vbptr_this_call:
-                return this->_this.value == right._this.value &&
-                    this->_fun._this_fun_vbptr == right._fun._this_fun_vbptr;
-            case CallType::multiple_this_call:
-                return this->_this.value == right._this.value &&
-                    this->_fun._this_fun_multiple == right._fun._this_fun_multiple;
-            case CallType::null:
-                return right.IsNull();
+                return (_this._ptr_vbptr->*(_fun._this_fun_vbptr))(params...);
+            case CallType::resolved_call:
+                return _fun.resolved_fun(_this.value, params...);
+            case CallType::bound_call:
+                return _this.bound_fun(&_fun, params...);
             default:
-                break;
+                return (_this._ptr_multiple->*(_fun._this_fun_multiple))(params...);
+            }
+        }
+#if mycodes_delegate_cpp17
+        //委托为空时返回 std::nullopt，不会抛出异常
+        invoke_opt_t<Ty_ret> InvokeOpt(const Ty_params&... params)const noexcept
+        {
+            if (this->IsNull())
+            {
+                if constexpr (std::is_void_v<Ty_ret>)
+                    return false;
+                else
+                    return std::nullopt;
             }
 
-            return false;
+            if constexpr (std::is_void_v<Ty_ret>)
+            {
+                InvokeUnchecked(params...);
+                return true;
+            }
+            else
+            {
+                return InvokeUnchecked(params...);
+            }
         }
-        const DelegateSingle& operator=(const DelegateSingle& right)noexcept
+#endif
+#if mycodes_delegate_expected
+        invoke_expected_t<Ty_ret> InvokeExpected(const Ty_params&... params)const noexcept
         {
-            this->_call_type = right._call_type;
-            this->_this = right._this;
-            this->_fun = right._fun;
-            return *this;
+            if (this->IsNull())
+                return std::unexpected(invoke_errc::null_delegate);
+
+            if constexpr (std::is_void_v<Ty_ret>)
+            {
+                InvokeUnchecked(params...);
+                return {};
+            }
+            else
+            {
+                return InvokeUnchecked(params...);
+            }
+        }
+#endif
+
+        //解除绑定
+        void UnBind()noexcept
+        {
+            _this.value = nullptr;
+            _fun.dvalue[0] = nullptr;   _fun.dvalue[1] = nullptr;
+            _call_type = CallType::null;
+        }
+
+        bool operator==(const DelegateSingle& right)const noexcept
+        {
+            return delegate_core::Equal(slotCopy(), right.slotCopy());
         }
+        DelegateSingle& operator=(const DelegateSingle& right) = default;
 
     protected:
         union ThisPtr
@@ -491,6 +1407,7 @@ namespace MyCodes
             Empty* _ptr;
             Empty_vbptr* _ptr_vbptr;
             Empty_multiple* _ptr_multiple;
+            Ty_ret(*bound_fun)(const void*, const Ty_params&...);
         };
         union CallFun
         {
@@ -500,8 +1417,97 @@ namespace MyCodes
             void* dvalue[2]{ nullptr,nullptr };
             Ty_ret(Empty_vbptr::* _this_fun_vbptr)(Ty_params...);
             Ty_ret(Empty_multiple::* _this_fun_multiple)(Ty_params...);
+            Ty_ret(*resolved_fun)(void*, Ty_params...);
         };
 
+        template<class CLS, class Fun>
+        void bindResolved(const CLS& __this, Fun __fun)noexcept
+        {
+        #if mycodes_delegate_resolve
+            //Itanium ABI 的成员函数指针：ptr 为函数地址或虚函数表偏移，adj 为 this 指针的调整
+            struct
+            {
+                uintptr_t ptr;
+                ptrdiff_t adj;
+            } pmf;
+            static_assert(sizeof(pmf) == sizeof(__fun), "BindResolved：不支持的成员函数指针格式");
+            std::memcpy(&pmf, &__fun, sizeof(pmf));
+            #if defined(__arm__) || defined(__aarch64__)
+            const bool is_virtual = (pmf.adj & 1) != 0;
+            const ptrdiff_t adj = pmf.adj >> 1;
+            const uintptr_t offset = pmf.ptr;
+            #else
+            const bool is_virtual = (pmf.ptr & 1) != 0;
+            const ptrdiff_t adj = pmf.adj;
+            const uintptr_t offset = pmf.ptr - 1;
+            #endif
+            char* obj = reinterpret_cast<char*>(const_cast<CLS*>(&__this)) + adj;
+            uintptr_t fun = pmf.ptr;
+            if (is_virtual)
+            {
+                const char* vtable = *reinterpret_cast<char* const*>(obj);
+                std::memcpy(&fun, vtable + offset, sizeof(fun));
+            }
+
+            _call_type = CallType::resolved_call;
+            _this.value = obj;
+            _fun.dvalue[1] = const_cast<CLS*>(&__this); //保存调整前的对象地址，用于 GetTarget
+            _fun.resolved_fun = reinterpret_cast<decltype(_fun.resolved_fun)>(fun);
+        #else
+            this->Bind(__this, __fun);
+        #endif
+        }
+
+#if mycodes_delegate_cpp17
+        template<class Bound>
+        void bindFront(Ty_ret(*thunk)(const void*, const Ty_params&...), const Bound& bound)noexcept
+        {
+            static_assert(std::is_trivially_copyable_v<Bound>, "BindFront：绑定的参数需要可以平凡复制");
+            static_assert(sizeof(Bound) <= bind_front_size && alignof(Bound) <= alignof(CallFun),
+                "BindFront：绑定的参数超过了 bind_front_size");
+
+            //bound 中的填充字节是不确定的，不能整体复制。先构造对象，再清零所有字节，
+            //最后逐个成员复制，保证未使用的字节和填充字节在比较时都为 0
+            unsigned char* storage = reinterpret_cast<unsigned char*>(new(&_fun) Bound(bound));
+            std::memset(storage, 0, sizeof(_fun));
+            bound.store(storage);
+            _this.bound_fun = thunk;
+            _call_type = CallType::bound_call;
+        }
+        template<class Bound, auto Fun>
+        static Ty_ret frontThunk(const void* storage, const Ty_params&... params)
+        {
+            return static_cast<const Bound*>(storage)->call([&](const auto&... bound)->Ty_ret
+                {
+                    return static_cast<Ty_ret>(std::invoke(Fun, bound..., params...));
+                });
+        }
+        template<class Bound>
+        static Ty_ret frontThunk_callable(const void* storage, const Ty_params&... params)
+        {
+            //展开后的第一个参数就是可调用对象本身
+            return static_cast<const Bound*>(storage)->call([&](const auto& fun, const auto&... bound)->Ty_ret
+                {
+                    return static_cast<Ty_ret>(fun(bound..., params...));
+                });
+        }
+#endif
+
+        const delegate_slot& slot()const noexcept
+        {
+            static_assert(sizeof(ThisPtr) == sizeof(delegate_slot::_this) && sizeof(CallFun) == sizeof(delegate_slot::_fun),
+                "DelegateSingle：布局与 delegate_slot 不同");
+            return *reinterpret_cast<const delegate_slot*>(this);
+        }
+        //按字节复制一份：DelegateSingle_any 中的底层委托以字节数组保存，是通过其他签名的类型写入的，
+        //直接以 delegate_slot 读取会违反严格别名规则
+        delegate_slot slotCopy()const noexcept
+        {
+            delegate_slot copy;
+            std::memcpy(&copy, &slot(), sizeof(delegate_slot));
+            return copy;
+        }
+
         CallType _call_type = CallType::null;
         ThisPtr _this;
         CallFun _fun;
@@ -513,32 +1519,34 @@ namespace MyCodes
     {
     public:
         using DelegateSingle_Type = _DelegateSingle<Ty_ret, Ty_params...>;
+        //DelegateSingle 使用与签名无关的 delegate_array，其他委托类型使用 std::vector
+        using Storage_Type = typename std::conditional<is_delegate_slot<DelegateSingle_Type>::value,
+            delegate_array<DelegateSingle_Type>, std::vector<DelegateSingle_Type>>::type;
         //添加委托
         template<class CLS>
         void Add(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...))noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind(__this, __fun);
-            m_allDels.push_back(temp);
+            addOne(temp);
         }
         template<class CLS>
         void Add(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind(__this, __fun);
-            m_allDels.push_back(temp);
+            addOne(temp);
         }
         //添加静态委托
         void Add(Ty_ret(*__fun)(Ty_params...))noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind(__fun);
-            m_allDels.push_back(temp);
+            addOne(temp);
         }
         void Add(const DelegateSingle_Type& del)noexcept
         {
-            if (!del.IsNull())
-                this->m_allDels.push_back(del);
+            addOne(del);
         }
         //添加lambda
         template<class Lambda>
@@ -549,14 +1557,33 @@ namespace MyCodes
         {
             DelegateSingle_Type temp;
             temp.Bind(lam);
-            this->m_allDels.push_back(temp);
+            addOne(temp);
         }
         Delegate_base& operator+=(const DelegateSingle_Type& del)noexcept
         {
-            if (!del.IsNull())
-                this->m_allDels.push_back(del);
+            addOne(del);
             return *this;
         }
+        //一次预留空间后添加一组委托，空委托会被跳过
+        template<class Iter>
+        void AddRange(Iter first, Iter last)
+        {
+            using category = typename std::iterator_traits<Iter>::iterator_category;
+            if (std::is_base_of<std::forward_iterator_tag, category>::value)
+                m_allDels.reserve(m_allDels.size() + static_cast<size_t>(std::distance(first, last)));
+            for (; first != last; ++first)
+            {
+                addOne(*first);
+            }
+            statsUpdate();
+        }
+        //添加排队委托，调用时委托会被投递到 loop 所在的线程中执行（见 delegate_queued.hpp）
+        template<class Loop, class...Options>
+        void Add(const DelegateSingle_Type& del, Loop& loop, const Options&... options)
+        {
+            if (!del.IsNull())
+                addOne(loop.Queue(del, options...));
+        }
 
 #if !mycodes_delegate_cpp20 //如果不支持c++20，就需要通过更多不同的函数来绑定不同的委托类型
         template<class CLS>
@@ -564,34 +1591,35 @@ namespace MyCodes
         {
             DelegateSingle_Type temp;
             temp.Bind_vbptr(__this, __fun);
-            m_allDels.push_back(temp);
+            addOne(temp);
         }
         template<class CLS>
         void Add_vbptr(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind_vbptr(__this, __fun);
-            m_allDels.push_back(temp);
+            addOne(temp);
         }
         template<class CLS>
         void Add_multiple(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...))noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind_multiple(__this, __fun);
-            m_allDels.push_back(temp);
+            addOne(temp);
         }
         template<class CLS>
         void Add_multiple(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind_multiple(__this, __fun);
-            m_allDels.push_back(temp);
+            addOne(temp);
         }
 #endif
 
         void Clear() noexcept
         {
             m_allDels.clear();
+            statsUpdate();
         }
         bool Empty()const noexcept
         {
@@ -601,11 +1629,13 @@ namespace MyCodes
         {
             return !Empty();
         }
-        const std::vector<DelegateSingle_Type>& GetArray()const noexcept
+        const Storage_Type& GetArray()const noexcept
         {
             return this->m_allDels;
         }
+    #if defined(_MSC_VER)
         _declspec(property(get = getsize)) const size_t size;
+    #endif
         const size_t getsize()const noexcept
         {
             return m_allDels.size();
@@ -613,6 +1643,8 @@ namespace MyCodes
         void swap(Delegate_base& _right)noexcept
         {
             this->m_allDels.swap(_right.m_allDels);
+            statsUpdate();
+            _right.statsUpdate();
         }
         auto begin()const noexcept
         {
@@ -625,14 +1657,16 @@ namespace MyCodes
 
         //触发调用
         Ty_ret Invoke(const Ty_params&... params)const 
-        #if mycodes_delegate_cpp17
+        #if mycodes_delegate_noexcept
+            noexcept
+        #elif mycodes_delegate_cpp17
             noexcept(std::is_void_v<Ty_ret>)
         #endif
         {
             for (size_t i = 0; i < m_allDels.size(); i++)
             {
                 #if mycodes_delegate_cpp17
-                IF_CONSTEXPR(!std::is_void_v<Ty_ret>)
+                IF_CONSTEXPR(!std::is_void<Ty_ret>::value)
                 #endif
                     if (i == m_allDels.size() - 1)
                     {
@@ -644,13 +1678,15 @@ namespace MyCodes
 
             #if mycodes_delegate_cpp17
             if constexpr (!std::is_void_v<Ty_ret>)
-                throw bad_invoke();
+                throwBadInvoke();
             #else
-                throw bad_invoke();
+                throwBadInvoke();
             #endif
         }
         Ty_ret operator()(const Ty_params&... params)const 
-        #if mycodes_delegate_cpp17
+        #if mycodes_delegate_noexcept
+            noexcept
+        #elif mycodes_delegate_cpp17
             noexcept(std::is_void_v<Ty_ret>)
         #endif
         {
@@ -668,66 +1704,156 @@ namespace MyCodes
                 return true;
             }
         }
+#if mycodes_delegate_cpp17
+        //多播委托为空时返回 std::nullopt，否则返回最后一个委托的返回值
+        invoke_opt_t<Ty_ret> InvokeOpt(const Ty_params&... params)const noexcept
+        {
+            if constexpr (std::is_void_v<Ty_ret>)
+            {
+                return TryInvoke(params...);
+            }
+            else
+            {
+                //与 Invoke 相同，调用过程中可能添加或删除委托，每次都重新读取数量
+                for (size_t i = 0; i < m_allDels.size(); i++)
+                {
+                    if (i == m_allDels.size() - 1)
+                        return m_allDels[i].InvokeUnchecked(params...);
+                    m_allDels[i].InvokeUnchecked(params...);
+                }
+                return std::nullopt;
+            }
+        }
+#endif
+#if mycodes_delegate_expected
+        invoke_expected_t<Ty_ret> InvokeExpected(const Ty_params&... params)const noexcept
+        {
+            if (Empty())
+                return std::unexpected(invoke_errc::null_delegate);
+
+            if constexpr (std::is_void_v<Ty_ret>)
+            {
+                Invoke(params...);
+                return {};
+            }
+            else
+            {
+                for (size_t i = 0; i < m_allDels.size(); i++)
+                {
+                    if (i == m_allDels.size() - 1)
+                        return m_allDels[i].InvokeUnchecked(params...);
+                    m_allDels[i].InvokeUnchecked(params...);
+                }
+                return std::unexpected(invoke_errc::null_delegate);
+            }
+        }
+#endif
 
         //删除委托
         template<class CLS>
-        bool Sub(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...))noexcept
+        bool Sub(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...))
         {
             DelegateSingle_Type temp;
             temp.Bind(__this, __fun);
-            return subDelegate(temp, m_allDels);
+            return subOne(temp);
         }
         template<class CLS>
-        bool Sub(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)noexcept
+        bool Sub(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)
         {
             DelegateSingle_Type temp;
             temp.Bind(__this, __fun);
-            return subDelegate(temp, m_allDels);
+            return subOne(temp);
         }
         //删除静态委托
-        bool Sub(Ty_ret(*__fun)(Ty_params...))noexcept
+        bool Sub(Ty_ret(*__fun)(Ty_params...))
         {
             DelegateSingle_Type temp;
             temp.Bind(__fun);
-            return subDelegate(temp, m_allDels);
+            return subOne(temp);
+        }
+        bool Sub(const DelegateSingle_Type& del)
+        {
+            return subOne(del);
+        }
+        bool operator-=(const DelegateSingle_Type& del)
+        {
+            return subOne(del);
         }
-        bool Sub(const DelegateSingle_Type& del)noexcept
+        //无序模式下删除委托时用最后一个委托填补空位，不再移动后面的所有委托，
+        //但不再保证调用顺序与添加顺序一致
+        void SetUnordered(bool unordered)noexcept
         {
-            return subDelegate(del, m_allDels);
+            m_unordered = unordered;
         }
-        bool operator-=(const DelegateSingle_Type& del)noexcept
+        bool IsUnordered()const noexcept
         {
-            return subDelegate(del, m_allDels);
+            return m_unordered;
+        }
+        //开启写时复制后，复制这个委托时只共享订阅者数组，修改时才复制（只有 Delegate 支持）
+        void SetCopyOnWrite(bool on)noexcept
+        {
+            static_assert(is_delegate_slot<DelegateSingle_Type>::value,
+                "SetCopyOnWrite：只有 Delegate 支持写时复制，Delegate_anyRet 使用 std::vector 存储");
+            m_allDels.set_copy_on_write(on);
+        }
+        bool IsCopyOnWrite()const noexcept
+        {
+            return m_allDels.copy_on_write();
+        }
+
+        //删除所有与 del 相等的委托，返回删除的数量
+        size_t SubAll(const DelegateSingle_Type& del)
+        {
+            const size_t count = subAllDelegate(del, m_allDels);
+            statsUpdate();
+            return count;
+        }
+        //删除所有绑定到 target 对象上的委托，返回删除的数量
+        size_t SubAllFor(const void* target)
+        {
+            const size_t count = subTargetDelegate(target, m_allDels);
+            statsUpdate();
+            return count;
+        }
+        //删除排队委托
+        template<class Loop>
+        bool Sub(const DelegateSingle_Type& del, Loop& loop)
+        {
+            DelegateSingle_Type stub = loop.FindQueued(del);
+            if (stub.IsNull() || !subOne(stub))
+                return false;
+            loop.Unqueue(del);
+            return true;
         }
 
 #if !mycodes_delegate_cpp20
         template<class CLS>
-        bool Sub_vbptr(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...))noexcept
+        bool Sub_vbptr(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...))
         {
             DelegateSingle_Type temp;
             temp.Bind_vbptr(__this, __fun);
-            return subDelegate(temp, m_allDels);
+            return subOne(temp);
         }
         template<class CLS>
-        bool Sub_vbptr(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)noexcept
+        bool Sub_vbptr(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)
         {
             DelegateSingle_Type temp;
             temp.Bind_vbptr(__this, __fun);
-            return subDelegate(temp, m_allDels);
+            return subOne(temp);
         }
         template<class CLS>
-        bool Sub_multiple(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...))noexcept
+        bool Sub_multiple(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...))
         {
             DelegateSingle_Type temp;
             temp.Bind_multiple(__this, __fun);
-            return subDelegate(temp, m_allDels);
+            return subOne(temp);
         }
         template<class CLS>
-        bool Sub_multiple(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)noexcept
+        bool Sub_multiple(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)
         {
             DelegateSingle_Type temp;
             temp.Bind_multiple(__this, __fun);
-            return subDelegate(temp, m_allDels);
+            return subOne(temp);
         }
 #endif
 
@@ -736,24 +1862,30 @@ namespace MyCodes
         {
             DelegateSingle_Type temp;
             temp.Bind(__this, __fun);
-            return haveDelegate(temp, m_allDels);
+            return haveOne(temp);
         }
         template<class CLS>
         bool Have(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)const noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind(__this, __fun);
-            return haveDelegate(temp, m_allDels);
+            return haveOne(temp);
         }
         bool Have(Ty_ret(*__fun)(Ty_params...))const noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind(__fun);
-            return haveDelegate(temp, m_allDels);
+            return haveOne(temp);
         }
         bool Have(const DelegateSingle_Type& del)const noexcept
         {
-            return haveDelegate(del, m_allDels);
+            return haveOne(del);
+        }
+        template<class Loop>
+        bool Have(const DelegateSingle_Type& del, const Loop& loop)const
+        {
+            DelegateSingle_Type stub = loop.FindQueued(del);
+            return !stub.IsNull() && haveOne(stub);
         }
 
 #if !mycodes_delegate_cpp20
@@ -762,32 +1894,74 @@ namespace MyCodes
         {
             DelegateSingle_Type temp;
             temp.Bind_vbptr(__this, __fun);
-            return haveDelegate(temp, m_allDels);
+            return haveOne(temp);
         }
         template<class CLS>
         bool Have_vbptr(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)const noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind_vbptr(__this, __fun);
-            return haveDelegate(temp, m_allDels);
+            return haveOne(temp);
         }
         template<class CLS>
         bool Have_multiple(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...))const noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind_multiple(__this, __fun);
-            return haveDelegate(temp, m_allDels);
+            return haveOne(temp);
         }
         template<class CLS>
         bool Have_multiple(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)const noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind_multiple(__this, __fun);
-            return haveDelegate(temp, m_allDels);
+            return haveOne(temp);
         }
 #endif
 
     protected:
+#if mycodes_delegate_stats
+        Delegate_base()
+        {
+            statsAttach();
+        }
+        Delegate_base(const Delegate_base& right)
+            :m_allDels(right.m_allDels), m_unordered(right.m_unordered)
+        {
+            statsAttach();
+        }
+        Delegate_base(Delegate_base&& right)
+            :m_allDels(std::move(right.m_allDels)), m_unordered(right.m_unordered)
+        {
+            statsAttach();
+            right.statsUpdate();
+        }
+        Delegate_base(size_t size)
+        {
+            m_allDels.reserve(size);
+            statsAttach();
+        }
+        Delegate_base& operator=(const Delegate_base& right)
+        {
+            m_allDels = right.m_allDels;
+            m_unordered = right.m_unordered;
+            statsUpdate();
+            return *this;
+        }
+        Delegate_base& operator=(Delegate_base&& right)
+        {
+            m_allDels = std::move(right.m_allDels);
+            m_unordered = right.m_unordered;
+            statsUpdate();
+            right.statsUpdate();
+            return *this;
+        }
+        void statsAttach()
+        {
+            statsUpdate();
+            m_stats.Attach(this, typeid(Delegate_base).name(), sizeof(DelegateSingle_Type));
+        }
+#else
         Delegate_base() = default;
         Delegate_base(const Delegate_base&) = default;
         Delegate_base(Delegate_base&&) = default;
@@ -795,61 +1969,52 @@ namespace MyCodes
         {
             m_allDels.reserve(size);
         }
-        std::vector<DelegateSingle_Type> m_allDels;
-    };
-
-    template<class Ty_ret, class... Ty_params>
-    class Delegate :public Delegate_base<DelegateSingle,Ty_ret, Ty_params...>
-    {
-    public:
-        Delegate(size_t size = 4) :Delegate_base<DelegateSingle, Ty_ret, Ty_params...>(size) {}
-        bool TryInvoke(_Out_ Ty_ret& out, _In_ const Ty_params&... params)const noexcept
+#endif
+        //所有 Add、Sub、Have 的重载只负责生成临时委托，实际的操作都在这里完成，
+        //每种签名只生成一份，不随绑定的类型增加
+        void addOne(const DelegateSingle_Type& del)
         {
-            if (this->Empty())
-            {
-                return false;
-            }
-            else
+            if (!del.IsNull())
             {
-                out = this->Invoke(params...);
-                return true;
+                m_allDels.push_back(del);
+                statsUpdate();
             }
         }
-        bool TryInvoke(const Ty_params&... params)const noexcept
+        bool subOne(const DelegateSingle_Type& del)
         {
-            return Delegate_base<DelegateSingle,Ty_ret, Ty_params...>::TryInvoke(params...);
+            const bool removed = m_unordered ? subDelegate_unordered(del, m_allDels) : subDelegate(del, m_allDels);
+            statsUpdate();
+            return removed;
         }
-    };
-
-    template<class Ty_ret, class...Ty_params>
-    class Delegate<const Ty_ret&, Ty_params...> :public Delegate_base<DelegateSingle,const Ty_ret&, Ty_params...>
-    {
-    public:
-        Delegate(size_t size = 4) :Delegate_base<DelegateSingle, const Ty_ret&, Ty_params...>(size) {}
-        bool TryInvoke(_Out_ Ty_ret& out, _In_ const Ty_params&... params)const noexcept
+        //订阅者数组改变后调用，统计时只读取原子的副本，未定义 MYCODES_DELEGATE_STATS 时为空函数
+        void statsUpdate()noexcept
         {
-            if (this->Empty())
-            {
-                return false;
-            }
-            else
-            {
-                out = this->Invoke(params...);
-                return true;
-            }
+        #if mycodes_delegate_stats
+            m_stats.Update(m_allDels.size(), m_allDels.capacity());
+        #endif
         }
-        bool TryInvoke(const Ty_params&... params)const noexcept
+        bool haveOne(const DelegateSingle_Type& del)const noexcept
         {
-            return Delegate_base<DelegateSingle, const Ty_ret&, Ty_params...>::TryInvoke(params...);
+            return haveDelegate(del, m_allDels);
         }
+
+        Storage_Type m_allDels;
+        bool m_unordered = false;
+#if mycodes_delegate_stats
+        //保存订阅者数量和容量的原子副本，统计时不访问 m_allDels
+        delegate_stats_hook m_stats;
+#endif
     };
 
-    template<class Ty_ret, class...Ty_params>
-    class Delegate<const Ty_ret, Ty_params...> :public Delegate_base<DelegateSingle,const Ty_ret, Ty_params...>
+    //返回值为 const 或引用时共用这个模板，TryInvoke 接受返回值的变量为去掉 const 和引用后的类型
+    template<class Ty_ret, class... Ty_params>
+    class Delegate :public Delegate_base<DelegateSingle,Ty_ret, Ty_params...>
     {
     public:
-        Delegate(size_t size = 4) :Delegate_base<DelegateSingle, const Ty_ret, Ty_params...>(size) {}
-        bool TryInvoke(_Out_ Ty_ret& out, _In_ const Ty_params&... params)const noexcept
+        using Ty_out = std::remove_const_t<std::remove_reference_t<Ty_ret>>;
+
+        Delegate(size_t size = 4) :Delegate_base<DelegateSingle, Ty_ret, Ty_params...>(size) {}
+        bool TryInvoke(_Out_ Ty_out& out, _In_ const Ty_params&... params)const noexcept
         {
             if (this->Empty())
             {
@@ -863,7 +2028,7 @@ namespace MyCodes
         }
         bool TryInvoke(const Ty_params&... params)const noexcept
         {
-            return Delegate_base<DelegateSingle, const Ty_ret, Ty_params...>::TryInvoke(params...);
+            return Delegate_base<DelegateSingle,Ty_ret, Ty_params...>::TryInvoke(params...);
         }
     };
 
@@ -886,7 +2051,7 @@ namespace MyCodes
     template<class _Ty_ret,class...Ty_params>
     class DelegateSingle_any
     {
-        static_assert(std::is_void_v<_Ty_ret>, "DelegateSingle_any模板的第一个参数应为void");
+        static_assert(std::is_void<_Ty_ret>::value, "DelegateSingle_any模板的第一个参数应为void");
     protected:
         using Byte = unsigned char;
         static CONSTEXPR size_t del_size = sizeof(DelegateSingle<void>);
@@ -1061,6 +2226,10 @@ namespace MyCodes
         {
             return top_del.IsNull();
         }
+        const void* GetTarget()const noexcept
+        {
+            return reinterpret_cast<const DelegateSingle<void>*>(this->bottom_del)->GetTarget();
+        }
         operator bool()const noexcept
         {
             return (bool)top_del;
@@ -1074,27 +2243,44 @@ namespace MyCodes
         using DelegateSingle_Type=typename Delegate_base<DelegateSingle_any, void, Ty_params...>::DelegateSingle_Type;
     public:
         Delegate_anyRet(size_t size = 4) :Delegate_base<DelegateSingle_any, void, Ty_params...>(size) {}
+
+        //排队委托
+        template<class Loop, class...Options>
+        void Add(const DelegateSingle_Type& del, Loop& loop, const Options&... options)
+        {
+            Delegate_base<DelegateSingle_any, void, Ty_params...>::Add(del, loop, options...);
+        }
+        template<class Loop>
+        bool Sub(const DelegateSingle_Type& del, Loop& loop)
+        {
+            return Delegate_base<DelegateSingle_any, void, Ty_params...>::Sub(del, loop);
+        }
+        template<class Loop>
+        bool Have(const DelegateSingle_Type& del, const Loop& loop)const
+        {
+            return Delegate_base<DelegateSingle_any, void, Ty_params...>::Have(del, loop);
+        }
   
         template<class CLS, class Ty_ret>
         void Add(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...))noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind(__this, __fun);
-            this->m_allDels.push_back(temp);
+            this->addOne(temp);
         }
         template<class CLS, class Ty_ret>
         void Add(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind(__this, __fun);
-            this->m_allDels.push_back(temp);
+            this->addOne(temp);
         }
         template<class Ty_ret>
         void Add(Ty_ret(*__fun)(Ty_params...))noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind(__fun);
-            this->m_allDels.push_back(temp);
+            this->addOne(temp);
         }
         template<class Lambda>
         #if mycodes_delegate_cpp20
@@ -1104,7 +2290,7 @@ namespace MyCodes
         {
             DelegateSingle_Type temp;
             temp.Bind(lam);
-            this->m_allDels.push_back(temp);
+            this->addOne(temp);
         }
 
 #if !mycodes_delegate_cpp20
@@ -1113,28 +2299,28 @@ namespace MyCodes
         {
             DelegateSingle_Type temp;
             temp.Bind_vbptr(__this, __fun);
-            this->m_allDels.push_back(temp);
+            this->addOne(temp);
         }
         template<class CLS,class Ty_ret>
         void Add_vbptr(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind_vbptr(__this, __fun);
-            this->m_allDels.push_back(temp);
+            this->addOne(temp);
         }
         template<class CLS, class Ty_ret>
         void Add_multiple (const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...))noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind_multiple(__this, __fun);
-            this->m_allDels.push_back(temp);
+            this->addOne(temp);
         }
         template<class CLS, class Ty_ret>
         void Add_multiple(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind_multiple(__this, __fun);
-            this->m_allDels.push_back(temp);
+            this->addOne(temp);
         }
 #endif  
         template<class CLS, class Ty_ret>
@@ -1142,31 +2328,31 @@ namespace MyCodes
         {
             DelegateSingle_Type temp;
             temp.Bind(__this, __fun);
-            return subDelegate(temp, this->m_allDels);
+            return this->subOne(temp);
         }
         template<class CLS, class Ty_ret>
         bool Sub(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind(__this, __fun);
-            return subDelegate(temp, this->m_allDels);
+            return this->subOne(temp);
         }
         template<class Ty_ret>
         bool Sub(Ty_ret(*__fun)(Ty_params...))noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind(__fun);
-            return subDelegate(temp, this->m_allDels);
+            return this->subOne(temp);
         }
         template<class Lambda>
         #if mycodes_delegate_cpp20
             requires is_lambda_any<Lambda, Ty_params...>
         #endif
-        void Sub(const Lambda& lam)
+        bool Sub(const Lambda& lam)
         {
             DelegateSingle_Type temp;
             temp.Bind(lam);
-            return subDelegate(temp, this->m_allDels);
+            return this->subOne(temp);
         }
 
 #if !mycodes_delegate_cpp20
@@ -1175,28 +2361,28 @@ namespace MyCodes
         {
             DelegateSingle_Type temp;
             temp.Bind_vbptr(__this, __fun);
-            return subDelegate(temp, this->m_allDels);
+            return this->subOne(temp);
         }
         template<class CLS, class Ty_ret>
         bool Sub_vbptr(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind_vbptr(__this, __fun);
-            return subDelegate(temp, this->m_allDels);
+            return this->subOne(temp);
         }
         template<class CLS, class Ty_ret>
         bool Sub_multiple(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...))noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind_multiple(__this, __fun);
-            return subDelegate(temp, this->m_allDels);
+            return this->subOne(temp);
         }
         template<class CLS, class Ty_ret>
         bool Sub_multiple(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind_multiple(__this, __fun);
-            return subDelegate(temp, this->m_allDels);
+            return this->subOne(temp);
         }
 #endif
 
@@ -1205,31 +2391,31 @@ namespace MyCodes
         {
             DelegateSingle_Type temp;
             temp.Bind(__this, __fun);
-            return haveDelegate(temp, this->m_allDels);
+            return this->haveOne(temp);
         }
         template<class CLS, class Ty_ret>
         bool Have(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind(__this, __fun);
-            return haveDelegate(temp, this->m_allDels);
+            return this->haveOne(temp);
         }
         template<class Ty_ret>
         bool Have(Ty_ret(*__fun)(Ty_params...))noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind(__fun);
-            return haveDelegate(temp, this->m_allDels);
+            return this->haveOne(temp);
         }
         template<class Lambda>
         #if mycodes_delegate_cpp20
             requires is_lambda_any<Lambda, Ty_params...>
         #endif
-        void Have(const Lambda& lam)
+        bool Have(const Lambda& lam)
         {
             DelegateSingle_Type temp;
             temp.Bind(lam);
-            return haveDelegate(temp, this->m_allDels);
+            return this->haveOne(temp);
         }
 
 #if !mycodes_delegate_cpp20
@@ -1238,28 +2424,28 @@ namespace MyCodes
         {
             DelegateSingle_Type temp;
             temp.Bind_vbptr(__this, __fun);
-            return haveDelegate(temp, this->m_allDels);
+            return this->haveOne(temp);
         }
         template<class CLS, class Ty_ret>
         bool Have_vbptr(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind_vbptr(__this, __fun);
-            return haveDelegate(temp, this->m_allDels);
+            return this->haveOne(temp);
         }
         template<class CLS, class Ty_ret>
         bool Have_multiple(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...))noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind_multiple(__this, __fun);
-            return haveDelegate(temp, this->m_allDels);
+            return this->haveOne(temp);
         }
         template<class CLS, class Ty_ret>
         bool Have_multiple(const CLS& __this, Ty_ret(CLS::* __fun)(Ty_params...)const)noexcept
         {
             DelegateSingle_Type temp;
             temp.Bind_multiple(__this, __fun);
-            return haveDelegate(temp, this->m_allDels);
+            return this->haveOne(temp);
         }
 #endif    
 };
@@ -1287,15 +2473,23 @@ namespace MyCodes
             return *this;
         }
 
-        bool Sub(const DelegateSingle& del)noexcept
+        bool Sub(const DelegateSingle& del)
         {
             return m_del->Sub(del);
         }
-        Delegate_view_base& operator-=(const DelegateSingle& del)noexcept
+        Delegate_view_base& operator-=(const DelegateSingle& del)
         {
             m_del->operator-=(del);
             return *this;
         }
+        size_t SubAll(const DelegateSingle& del)
+        {
+            return m_del->SubAll(del);
+        }
+        size_t SubAllFor(const void* target)
+        {
+            return m_del->SubAllFor(target);
+        }
 
         bool Have(const DelegateSingle& del)const noexcept
         {
@@ -1304,7 +2498,7 @@ namespace MyCodes
 
         size_t size()const noexcept
         {
-            return m_del->size;
+            return m_del->getsize();
         }
         bool Empty()const noexcept
         {
@@ -1346,7 +2540,16 @@ namespace MyCodes
 
 #undef mycodes_delegate_cpp20
 #undef mycodes_delegate_cpp17
+#undef mycodes_delegate_noexcept
+#undef mycodes_delegate_resolve
+#undef mycodes_delegate_stats
+#undef mycodes_delegate_expected
 #pragma pop_macro("IF_CONSTEXPR")
 #pragma pop_macro("CONSTEXPR")
+#if defined(_MSC_VER)
 #pragma warning(default:6011)
 #pragma warning(default:6101)
+#else
+#pragma pop_macro("_In_")
+#pragma pop_macro("_Out_")
+#endif
@@ -0,0 +1,40 @@
+/*
+    delegate.hpp 的 c++20 模块接口
+    用法示例:
+        import delegate;
+        MyCodes::Delegate<void,int> del;
+
+    其他:
+        1、模块只是对 delegate.hpp 的包装，c++14/17 的项目继续包含 delegate.hpp 即可。
+           同一个项目中两者可以混用，得到的是同一组类型。
+        2、模块中的模板只在编译模块时解析一次，导入模块的翻译单元不再重复解析
+           delegate.hpp 及其包含的标准库头文件。
+        3、其他扩展头文件（delegate_*.hpp）仍以头文件的方式包含。
+        4、只导出公开的类型，delegate_core、delegate_slot、subDelegate 等内部实现不导出。
+*/
+module;
+#include"delegate.hpp"
+export module delegate;
+
+export namespace MyCodes
+{
+    //只导出公开的类型，delegate_core、subDelegate 等内部实现不导出
+    using MyCodes::bad_invoke;
+    using MyCodes::invoke_opt;
+    using MyCodes::invoke_opt_t;
+#if defined(__cpp_lib_expected)
+    using MyCodes::invoke_errc;
+    using MyCodes::invoke_expected;
+    using MyCodes::invoke_expected_t;
+#endif
+    using MyCodes::delegate_array;      //Delegate::GetArray 的返回类型
+
+    using MyCodes::DelegateSingle;
+    using MyCodes::Delegate;
+    using MyCodes::DelegateSingle_any;
+    using MyCodes::Delegate_anyRet;
+    using MyCodes::Delegate_view;
+    using MyCodes::Delegate_anyRet_view;
+    using MyCodes::Event;
+    using MyCodes::Event_view;
+}
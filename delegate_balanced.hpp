@@ -0,0 +1,326 @@
+/*
+    负载均衡的单播委托，每次调用只分发给其中一个订阅者
+    用法示例:
+        BalancedDelegate<void,const Job&> pool(BalancePolicy::least_loaded);
+        for (auto& worker : workers)
+            pool.Add(worker, &Worker::Process);     //加入工作者池
+        pool(job);                                  //任意线程调用，只有一个工作者处理 job
+
+        BalancedDelegate<void,const Request&> shards(BalancePolicy::key_hash);
+        shards.SetKey([](const Request& r) { return std::hash<int>()(r.userId); });
+        shards(request);                            //同一个用户的请求总是交给同一个工作者
+        shards.InvokeKey(42, request);              //也可以直接给出键
+
+    其他:
+        1、round_robin 依次轮流选择；least_loaded 选择正在执行的调用最少的订阅者（相同时轮流
+           选择）；key_hash 用最高随机权重哈希（rendezvous hashing）按键选择，订阅者加入或离开时
+           只有原来分配给该订阅者的键会改变归属。key_hash 模式没有设置 SetKey 时按 round_robin
+           选择。
+        2、选择过程只有原子操作，不加锁，可以在任意多个线程中同时调用。Add、Sub 在互斥锁下
+           生成新的订阅者快照并原子地替换，正在进行的调用继续使用旧的快照，不受影响；订阅者
+           在 Sub 之后仍可能被正在进行的调用执行，需要等这些调用结束后再销毁订阅者。
+           调用方用危险指针（hazard pointer）声明自己正在使用的快照，读取快照时没有引用计数的
+           原子读改写，也不会在多个调用线程之间争抢同一个缓存行。被替换的快照在没有调用方
+           使用后，由之后的 Add、Sub、Clear 或析构函数释放。每个线程第一次调用时会分配一个
+           危险指针记录（所有 BalancedDelegate 共用，线程结束后供其他线程复用）。
+        3、每个订阅者都有自己的正在执行计数（独占一个缓存行），调用前加一、返回（或抛出异常）后
+           减一，所有策略都会维护这个计数，可以通过 GetLoad 查看。
+        4、没有订阅者时，返回 void 的委托什么也不做，否则抛出 bad_invoke。TryInvoke 返回是否
+           选到了订阅者。
+        5、与其他委托一样，捕获了变量的 lambda 只保存引用，需要保证其生命周期。
+*/
+#pragma once
+#include<mutex>
+#include<atomic>
+#include<memory>
+#include<vector>
+#include<cstdint>
+#include"delegate_hazard.hpp"
+#if MYCODES_DELEGATE_LANG < 201703L
+#error(delegate_balanced.hpp：请使用c++17及以上的版本)
+#endif
+
+namespace MyCodes
+{
+    enum class BalancePolicy
+    {
+        round_robin,    //轮流选择
+        least_loaded,   //选择正在执行的调用最少的订阅者
+        key_hash        //按键选择，同一个键总是选择同一个订阅者
+    };
+
+    template<class Ty_ret, class...Ty_params>
+    class BalancedDelegate //负载均衡的单播委托
+    {
+    public:
+        using DelegateSingle_Type = DelegateSingle<Ty_ret, Ty_params...>;
+        using KeyFun = DelegateSingle<size_t, const Ty_params&...>;
+
+        BalancedDelegate(BalancePolicy policy = BalancePolicy::round_robin)
+            :m_policy(policy)
+        {
+            m_pool.store(new Pool(), std::memory_order_relaxed);
+        }
+        BalancedDelegate(const BalancedDelegate&) = delete;
+        BalancedDelegate& operator=(const BalancedDelegate&) = delete;
+        //析构时不能有正在进行的调用
+        ~BalancedDelegate()
+        {
+            delete m_pool.load(std::memory_order_relaxed);
+            for (const Pool* pool : m_retired)
+                delete pool;
+        }
+
+        //添加订阅者
+        void Add(const DelegateSingle_Type& del)
+        {
+            if (del.IsNull())
+                return;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto worker = std::make_shared<Worker>();
+            worker->del = del;
+            worker->seed = mix(m_seed += 0x9E3779B97F4A7C15ull);
+            std::unique_ptr<Pool> pool(new Pool(*m_pool.load(std::memory_order_relaxed)));
+            pool->push_back(std::move(worker));
+            replacePool(std::move(pool));
+        }
+        template<class...Args>
+        void Add(const Args&... args)
+        {
+            DelegateSingle_Type temp;
+            temp.Bind(args...);
+            Add(temp);
+        }
+        BalancedDelegate& operator+=(const DelegateSingle_Type& del)
+        {
+            Add(del);
+            return *this;
+        }
+
+        //删除订阅者，正在进行的调用不受影响
+        bool Sub(const DelegateSingle_Type& del)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            //只有持有互斥锁的写入方会释放快照，这里不需要危险指针
+            const Pool& current = *m_pool.load(std::memory_order_relaxed);
+            for (size_t i = current.size(); i > 0; i--)
+            {
+                if (current[i - 1]->del == del)
+                {
+                    std::unique_ptr<Pool> pool(new Pool(current));
+                    pool->erase(pool->begin() + (i - 1));
+                    replacePool(std::move(pool));
+                    return true;
+                }
+            }
+            return false;
+        }
+        template<class...Args>
+        bool Sub(const Args&... args)
+        {
+            DelegateSingle_Type temp;
+            temp.Bind(args...);
+            return Sub(temp);
+        }
+        bool operator-=(const DelegateSingle_Type& del)
+        {
+            return Sub(del);
+        }
+
+        bool Have(const DelegateSingle_Type& del)const
+        {
+            const Pool_guard pool(m_pool);
+            for (const auto& worker : *pool)
+            {
+                if (worker->del == del)
+                    return true;
+            }
+            return false;
+        }
+        void Clear()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            replacePool(std::unique_ptr<Pool>(new Pool()));
+        }
+        bool Empty()const
+        {
+            return Pool_guard(m_pool)->empty();
+        }
+        size_t getsize()const
+        {
+            return Pool_guard(m_pool)->size();
+        }
+
+        void SetPolicy(BalancePolicy policy)noexcept
+        {
+            m_policy.store(policy, std::memory_order_relaxed);
+        }
+        BalancePolicy GetPolicy()const noexcept
+        {
+            return m_policy.load(std::memory_order_relaxed);
+        }
+        //key_hash 模式下根据参数计算键的函数，需要在调用之前设置
+        void SetKey(const KeyFun& key)noexcept
+        {
+            m_key = key;
+        }
+        //与 del 相等的订阅者正在执行的调用数量
+        size_t GetLoad(const DelegateSingle_Type& del)const
+        {
+            const Pool_guard pool(m_pool);
+            for (const auto& worker : *pool)
+            {
+                if (worker->del == del)
+                    return worker->inflight.load(std::memory_order_relaxed);
+            }
+            return 0;
+        }
+
+        //按策略选择一个订阅者并调用
+        Ty_ret Invoke(const Ty_params&... params)const
+        {
+            const Pool_guard pool(m_pool);
+            if (pool->empty())
+            {
+                if constexpr (std::is_void_v<Ty_ret>)
+                    return;
+                else
+                    throwBadInvoke();
+            }
+            return call(select(*pool, params...), params...);
+        }
+        Ty_ret operator()(const Ty_params&... params)const
+        {
+            return Invoke(params...);
+        }
+        //调用键 key 对应的订阅者，与策略无关
+        Ty_ret InvokeKey(size_t key, const Ty_params&... params)const
+        {
+            const Pool_guard pool(m_pool);
+            if (pool->empty())
+            {
+                if constexpr (std::is_void_v<Ty_ret>)
+                    return;
+                else
+                    throwBadInvoke();
+            }
+            return call(selectKey(*pool, key), params...);
+        }
+        bool TryInvoke(const Ty_params&... params)const
+        {
+            const Pool_guard pool(m_pool);
+            if (pool->empty())
+                return false;
+            call(select(*pool, params...), params...);
+            return true;
+        }
+
+    protected:
+        struct alignas(64) Worker
+        {
+            DelegateSingle_Type del;
+            uint64_t seed = 0;                          //key_hash 使用的随机权重种子
+            mutable std::atomic<size_t> inflight{ 0 };  //正在执行的调用数量
+        };
+        //订阅者的快照，Worker 由写入方通过 shared_ptr 在新旧快照之间共享
+        using Pool = std::vector<std::shared_ptr<Worker>>;
+
+        //读取快照：声明危险指针后再次确认快照没有被替换，之后写入方不会释放它
+        using Pool_guard = delegate_hazard::Guard<Pool>;
+
+        struct Inflight_guard
+        {
+            Inflight_guard(std::atomic<size_t>& count)noexcept
+                :count(count)
+            {
+                count.fetch_add(1, std::memory_order_relaxed);
+            }
+            ~Inflight_guard()
+            {
+                count.fetch_sub(1, std::memory_order_relaxed);
+            }
+            std::atomic<size_t>& count;
+        };
+
+        static uint64_t mix(uint64_t value)noexcept
+        {
+            value ^= value >> 30;
+            value *= 0xBF58476D1CE4E5B9ull;
+            value ^= value >> 27;
+            value *= 0x94D049BB133111EBull;
+            value ^= value >> 31;
+            return value;
+        }
+
+        static Ty_ret call(const Worker& worker, const Ty_params&... params)
+        {
+            Inflight_guard guard(worker.inflight);
+            return worker.del.InvokeUnchecked(params...);
+        }
+
+        const Worker& select(const Pool& pool, const Ty_params&... params)const
+        {
+            const size_t size = pool.size();
+            switch (m_policy.load(std::memory_order_relaxed))
+            {
+            case BalancePolicy::least_loaded:
+            {
+                //从轮流的位置开始查找，负载相同时不会总是选择第一个
+                const size_t first = m_next.fetch_add(1, std::memory_order_relaxed) % size;
+                size_t best = first;
+                size_t bestLoad = pool[first]->inflight.load(std::memory_order_relaxed);
+                for (size_t i = 1; i < size && bestLoad != 0; i++)
+                {
+                    const size_t index = (first + i) % size;
+                    const size_t load = pool[index]->inflight.load(std::memory_order_relaxed);
+                    if (load < bestLoad)
+                    {
+                        best = index;
+                        bestLoad = load;
+                    }
+                }
+                return *pool[best];
+            }
+            case BalancePolicy::key_hash:
+                if (!m_key.IsNull())
+                    return selectKey(pool, m_key.InvokeUnchecked(params...));
+                [[fallthrough]];
+            default:
+                return *pool[m_next.fetch_add(1, std::memory_order_relaxed) % size];
+            }
+        }
+        //最高随机权重哈希：选择与键组合后得分最高的订阅者
+        static const Worker& selectKey(const Pool& pool, size_t key)noexcept
+        {
+            const uint64_t hashed = mix(static_cast<uint64_t>(key));
+            const Worker* best = pool[0].get();
+            uint64_t bestScore = mix(hashed ^ best->seed);
+            for (size_t i = 1; i < pool.size(); i++)
+            {
+                const uint64_t score = mix(hashed ^ pool[i]->seed);
+                if (score > bestScore)
+                {
+                    best = pool[i].get();
+                    bestScore = score;
+                }
+            }
+            return *best;
+        }
+
+        //替换快照并释放没有调用方使用的旧快照，需要持有 m_mutex
+        void replacePool(std::unique_ptr<Pool> pool)
+        {
+            m_retired.reserve(m_retired.size() + 1);
+            m_retired.push_back(m_pool.exchange(pool.release(), std::memory_order_seq_cst));
+            delegate_hazard::Reclaim(m_retired);
+        }
+
+        std::atomic<BalancePolicy> m_policy;
+        KeyFun m_key;
+        std::mutex m_mutex;             //只在 Add、Sub、Clear 时使用
+        uint64_t m_seed = 0;
+        std::vector<const Pool*> m_retired;     //已经被替换、可能仍有调用方在使用的快照
+        alignas(64) mutable std::atomic<size_t> m_next{ 0 };
+        std::atomic<const Pool*> m_pool;
+    };
+}
@@ -0,0 +1,268 @@
+/*
+    合并（防抖）事件包装
+    用法示例:
+        Delegate<void,const float&> onMove;         //原始事件
+        CoalescingEvent<const float&> move(onMove); //包装原始事件
+        move.Raise(1.0f);                           //只保存参数，不触发
+        move.Raise(2.0f);                           //覆盖上一次的参数，计为被合并一次
+        move.Flush();                               //onMove 只被调用一次，参数为 2.0f
+
+    其他:
+        1、CoalescingEvent 只保存最近一次 Raise 的参数。若构造时（或通过 SetMerge）
+           提供了合并函数，则新参数会通过合并函数并入已保存的参数，而不是直接覆盖。
+           合并函数的第一个参数为已保存的参数元组，第二个参数为新传入的参数元组。
+        2、除了手动调用 Flush 以外，也可以通过 SetWindow 设置时间窗口，然后在每帧
+           （或每次循环）中调用 Poll，Poll 保证在一个时间窗口内最多触发一次原始事件。
+        3、KeyedCoalescingEvent 按键合并，每个键只保留最后一次的参数。Flush 时按每个
+           键第一次 Raise 的顺序依次触发原始事件。
+        4、GetRaisedCount、GetAbsorbedCount、GetFiredCount 分别返回 Raise 的次数、被
+           合并掉（未单独触发）的次数以及实际触发原始事件的次数，可用于评估合并效果。
+        5、这些包装只保存原始事件的指针，需保证原始事件的生命周期长于包装对象。
+           包装对象本身不是线程安全的，Raise 与 Flush/Poll 应在同一线程调用。
+*/
+#pragma once
+#include<tuple>
+#include<vector>
+#include<chrono>
+#include<optional>
+#include<unordered_map>
+#include"delegate.hpp"
+#if MYCODES_DELEGATE_LANG < 201703L
+#error(delegate_coalescing.hpp：请使用c++17及以上的版本)
+#endif
+
+namespace MyCodes
+{
+    class Coalescing_counter //合并计数
+    {
+    public:
+        size_t GetRaisedCount()const noexcept
+        {
+            return m_raised;
+        }
+        size_t GetAbsorbedCount()const noexcept
+        {
+            return m_absorbed;
+        }
+        size_t GetFiredCount()const noexcept
+        {
+            return m_fired;
+        }
+        void ResetCounters()noexcept
+        {
+            m_raised = 0;
+            m_absorbed = 0;
+            m_fired = 0;
+        }
+    protected:
+        size_t m_raised = 0;
+        size_t m_absorbed = 0;
+        size_t m_fired = 0;
+    };
+
+    template<class...Ty_params>
+    class CoalescingEvent :public Coalescing_counter //合并事件
+    {
+    public:
+        using DelegateType = Delegate<void, Ty_params...>;
+        using Args = std::tuple<std::decay_t<Ty_params>...>;
+        using MergeFun = DelegateSingle<void, Args&, const Args&>;
+        using Clock = std::chrono::steady_clock;
+
+        CoalescingEvent(DelegateType& del)noexcept
+        {
+            m_del = &del;
+        }
+        CoalescingEvent(DelegateType& del, const MergeFun& merge)noexcept
+        {
+            m_del = &del;
+            m_merge = merge;
+        }
+
+        void SetMerge(const MergeFun& merge)noexcept
+        {
+            m_merge = merge;
+        }
+        //设置时间窗口，Poll 在一个窗口内最多触发一次
+        void SetWindow(Clock::duration window)noexcept
+        {
+            m_window = window;
+        }
+
+        //记录参数，不触发原始事件
+        void Raise(const Ty_params&... params)
+        {
+            m_raised++;
+            if (m_args.has_value())
+            {
+                m_absorbed++;
+                if (m_merge)
+                    m_merge(*m_args, Args(params...));
+                else
+                    *m_args = Args(params...);
+            }
+            else
+            {
+                m_args.emplace(params...);
+            }
+        }
+        void operator()(const Ty_params&... params)
+        {
+            Raise(params...);
+        }
+
+        //若有未触发的参数，则触发一次原始事件
+        bool Flush()
+        {
+            if (!m_args.has_value())
+                return false;
+
+            //先取出参数再调用，订阅者在调用过程中再次 Raise 时不会丢失参数
+            Args args = std::move(*m_args);
+            m_args.reset();
+            m_last = Clock::now();
+            m_fired++;
+            std::apply([this](const auto&... params) { m_del->Invoke(params...); }, args);
+            return true;
+        }
+        //距离上次触发已超过时间窗口时才触发
+        bool Poll(Clock::time_point now = Clock::now())
+        {
+            if (!m_args.has_value() || now - m_last < m_window)
+                return false;
+            return Flush();
+        }
+        //丢弃未触发的参数
+        void Discard()noexcept
+        {
+            m_args.reset();
+        }
+        bool Pending()const noexcept
+        {
+            return m_args.has_value();
+        }
+
+    protected:
+        DelegateType* m_del;
+        MergeFun m_merge;
+        std::optional<Args> m_args;
+        Clock::duration m_window = Clock::duration::zero();
+        Clock::time_point m_last;
+    };
+
+    template<class Key, class...Ty_params>
+    class KeyedCoalescingEvent :public Coalescing_counter //按键合并的事件
+    {
+    public:
+        using DelegateType = Delegate<void, Ty_params...>;
+        using Args = std::tuple<std::decay_t<Ty_params>...>;
+        using MergeFun = DelegateSingle<void, Args&, const Args&>;
+        using Clock = std::chrono::steady_clock;
+
+        KeyedCoalescingEvent(DelegateType& del)noexcept
+        {
+            m_del = &del;
+        }
+        KeyedCoalescingEvent(DelegateType& del, const MergeFun& merge)noexcept
+        {
+            m_del = &del;
+            m_merge = merge;
+        }
+
+        void SetMerge(const MergeFun& merge)noexcept
+        {
+            m_merge = merge;
+        }
+        void SetWindow(Clock::duration window)noexcept
+        {
+            m_window = window;
+        }
+
+        void Raise(const Key& key, const Ty_params&... params)
+        {
+            m_raised++;
+            auto it = m_index.find(key);
+            if (it != m_index.end())
+            {
+                m_absorbed++;
+                Args& args = m_pending[it->second];
+                if (m_merge)
+                    m_merge(args, Args(params...));
+                else
+                    args = Args(params...);
+            }
+            else
+            {
+                m_index.emplace(key, m_pending.size());
+                m_pending.emplace_back(params...);
+            }
+        }
+        void operator()(const Key& key, const Ty_params&... params)
+        {
+            Raise(key, params...);
+        }
+
+        //按键第一次 Raise 的顺序触发所有未触发的参数
+        bool Flush()
+        {
+            if (m_pending.empty())
+                return false;
+
+            //先把参数移到局部的数组中再调用，订阅者在调用过程中再次 Raise 或 Flush 不会影响本次遍历。
+            //m_flushing 只是备用的容量，与两边交换后稳定下来不再分配内存
+            std::vector<Args> batch;
+            batch.swap(m_flushing);
+            batch.swap(m_pending);
+            m_index.clear();
+            m_last = Clock::now();
+            Recycle_guard guard{ batch, m_flushing };
+            for (const auto& args : batch)
+            {
+                m_fired++;
+                std::apply([this](const auto&... params) { m_del->Invoke(params...); }, args);
+            }
+            return true;
+        }
+        bool Poll(Clock::time_point now = Clock::now())
+        {
+            if (m_pending.empty() || now - m_last < m_window)
+                return false;
+            return Flush();
+        }
+        void Discard()noexcept
+        {
+            m_pending.clear();
+            m_index.clear();
+        }
+        bool Pending()const noexcept
+        {
+            return !m_pending.empty();
+        }
+        size_t PendingCount()const noexcept
+        {
+            return m_pending.size();
+        }
+
+    protected:
+        //调用结束（或抛出异常）后清空本次的参数，把容量留给下一次 Flush
+        struct Recycle_guard
+        {
+            ~Recycle_guard()
+            {
+                batch.clear();
+                if (spare.capacity() < batch.capacity())
+                    spare.swap(batch);
+            }
+            std::vector<Args>& batch;
+            std::vector<Args>& spare;
+        };
+
+        DelegateType* m_del;
+        MergeFun m_merge;
+        std::unordered_map<Key, size_t> m_index;
+        std::vector<Args> m_pending;
+        std::vector<Args> m_flushing;
+        Clock::duration m_window = Clock::duration::zero();
+        Clock::time_point m_last;
+    };
+}
@@ -0,0 +1,317 @@
+/*
+    基于委托的数据流图，变化按拓扑顺序增量传播
+    用法示例:
+        DataflowGraph graph;
+        Source<float> width(graph, 1), height(graph, 2);
+        Computed<float, float, float> area(graph, [](const float& w, const float& h) { return w * h; }, width, height);
+        Computed<bool, float> big(graph, [](const float& a) { return a > 100; }, area);
+        big.OnChanged += onBigChanged;              //值真正改变时才调用
+        width.Set(10);                              //只标记依赖的节点，不立即计算
+        height.Set(20);
+        graph.Flush();                              //area 和 big 各计算一次
+        float a = area.Get();                       //也可以不 Flush，直接拉取时按需计算
+
+    其他:
+        1、Computed 构造时传入计算函数和输入节点，节点的层级为输入节点层级的最大值加一，
+           因此图一定是无环的。构造时会立即计算一次初始值。
+        2、Source::Set 只在新值与旧值不相等时才增加版本号，并把直接依赖它的节点加入待计算
+           队列。Flush 按层级从低到高依次处理队列中的节点，每个节点最多计算一次：只有当某个
+           输入节点的版本号变化时才重新计算，计算结果与旧值相等时不增加版本号，也不会再标记
+           后面的节点，因此菱形依赖中的汇合节点只计算一次，未变化的分支会被整体跳过。
+        3、Get 会先按需计算所有上游节点（拉取），不需要等待 Flush。上游没有任何 Set 时，
+           Get 只比较一次全局的版本号。
+        4、节点的 OnChanged 在值改变时调用，参数为新值；回调中可以 Get 其他节点，得到的
+           一定是一致的值。回调中也可以 Set 其他源节点，Flush 会继续处理新产生的变化。
+        5、计算函数是 DelegateSingle，与其他委托一样，捕获了变量的 lambda 只保存引用，需要保证其
+           生命周期长于节点。值的类型需要可以用 == 比较。节点需要在依赖它的节点之后析构（按声明的相反顺序析构的
+           局部变量或成员变量自然满足），图需要在所有节点之后析构。数据流图不是线程安全的。
+        6、GetEvaluatedCount 和 GetSkippedCount 分别返回计算的次数和因为输入未变化而跳过的次数。
+        7、计算函数抛出的异常会传给 Flush 或 Get 的调用者，此时节点不会记录输入的版本号，仍然是
+           过期的，之后 Get 它（或依赖它的节点）时会重新计算。
+*/
+#pragma once
+#include<tuple>
+#include<vector>
+#include<cstdint>
+#include<algorithm>
+#include"delegate.hpp"
+#if MYCODES_DELEGATE_LANG < 201703L
+#error(delegate_dataflow.hpp：请使用c++17及以上的版本)
+#endif
+
+namespace MyCodes
+{
+    class DataflowGraph;
+
+    class DataflowNode_base //数据流节点基类
+    {
+        friend class DataflowGraph;
+    public:
+        DataflowNode_base(const DataflowNode_base&) = delete;
+        DataflowNode_base& operator=(const DataflowNode_base&) = delete;
+
+        size_t GetRank()const noexcept
+        {
+            return m_rank;
+        }
+        //值每改变一次版本号加一
+        uint64_t GetVersion()const noexcept
+        {
+            return m_version;
+        }
+
+    protected:
+        inline DataflowNode_base(DataflowGraph& graph)noexcept;
+        inline virtual ~DataflowNode_base();
+
+        void addInput(DataflowNode_base& input)
+        {
+            m_inputs.push_back(&input);
+            m_seen.push_back(input.m_version);
+            input.m_dependents.push_back(this);
+            m_rank = std::max(m_rank, input.m_rank + 1);
+        }
+
+        //重新计算并保存新值，值改变时返回 true
+        virtual bool evaluate()
+        {
+            return false;
+        }
+        //值改变后调用
+        virtual void notify()
+        {
+        }
+
+        //确保节点的值是最新的，返回是否重新计算了
+        inline bool ensure();
+        inline void changed();
+        //源节点的值被修改
+        inline void sourceChanged();
+
+        DataflowGraph* m_graph;
+        std::vector<DataflowNode_base*> m_inputs;
+        std::vector<uint64_t> m_seen;   //上一次计算时各个输入节点的版本号
+        std::vector<DataflowNode_base*> m_dependents;
+        size_t m_rank = 0;
+        uint64_t m_version = 0;
+        uint64_t m_checked = 0;         //上一次确认为最新时图的版本号
+        bool m_queued = false;
+    };
+
+    class DataflowGraph //数据流图
+    {
+        friend class DataflowNode_base;
+    public:
+        DataflowGraph() = default;
+        DataflowGraph(const DataflowGraph&) = delete;
+        DataflowGraph& operator=(const DataflowGraph&) = delete;
+
+        //按层级从低到高计算所有待计算的节点
+        void Flush()
+        {
+            while (m_queuedCount != 0)
+            {
+                for (size_t rank = 0; rank < m_buckets.size() && m_queuedCount != 0; rank++)
+                {
+                    //计算过程中会向更高层（回调中也可能向任意层）加入节点，m_buckets 可能扩容，因此按下标访问
+                    for (size_t i = 0; i < m_buckets[rank].size(); i++)
+                    {
+                        DataflowNode_base* node = m_buckets[rank][i];
+                        if (node == nullptr)
+                            continue;
+                        m_buckets[rank][i] = nullptr;
+                        node->m_queued = false;
+                        m_queuedCount--;
+                        if (node->m_checked != m_epoch && !node->ensure())
+                            m_skipped++;
+                    }
+                    m_buckets[rank].clear();
+                }
+            }
+        }
+        bool NeedFlush()const noexcept
+        {
+            return m_queuedCount != 0;
+        }
+
+        size_t GetEvaluatedCount()const noexcept
+        {
+            return m_evaluated;
+        }
+        size_t GetSkippedCount()const noexcept
+        {
+            return m_skipped;
+        }
+        void ResetCounters()noexcept
+        {
+            m_evaluated = 0;
+            m_skipped = 0;
+        }
+
+    protected:
+        void enqueue(DataflowNode_base& node)
+        {
+            if (node.m_queued)
+                return;
+            if (m_buckets.size() <= node.m_rank)
+                m_buckets.resize(node.m_rank + 1);
+            m_buckets[node.m_rank].push_back(&node);
+            node.m_queued = true;
+            m_queuedCount++;
+        }
+        void dequeue(DataflowNode_base& node)noexcept
+        {
+            if (!node.m_queued)
+                return;
+            auto& bucket = m_buckets[node.m_rank];
+            std::replace(bucket.begin(), bucket.end(), &node, static_cast<DataflowNode_base*>(nullptr));
+            node.m_queued = false;
+            m_queuedCount--;
+        }
+
+        std::vector<std::vector<DataflowNode_base*>> m_buckets;  //按层级存放的待计算节点
+        size_t m_queuedCount = 0;
+        uint64_t m_epoch = 1;           //任何源节点改变时加一
+        size_t m_evaluated = 0;
+        size_t m_skipped = 0;
+    };
+
+    inline DataflowNode_base::DataflowNode_base(DataflowGraph& graph)noexcept
+        :m_graph(&graph), m_checked(graph.m_epoch)
+    {
+    }
+    inline DataflowNode_base::~DataflowNode_base()
+    {
+        m_graph->dequeue(*this);
+        for (DataflowNode_base* input : m_inputs)
+        {
+            auto& deps = input->m_dependents;
+            deps.erase(std::find(deps.begin(), deps.end(), this));
+        }
+    }
+    inline bool DataflowNode_base::ensure()
+    {
+        if (m_checked == m_graph->m_epoch)
+            return false;
+
+        bool stale = false;
+        for (size_t i = 0; i < m_inputs.size(); i++)
+        {
+            m_inputs[i]->ensure();
+            if (m_inputs[i]->m_version != m_seen[i])
+                stale = true;
+        }
+        if (!stale)
+        {
+            m_checked = m_graph->m_epoch;
+            return false;
+        }
+
+        m_graph->m_evaluated++;
+        const bool different = evaluate();
+        //计算成功后才记录输入的版本，计算函数抛出异常时节点仍然是过期的，下一次拉取会重新计算
+        for (size_t i = 0; i < m_inputs.size(); i++)
+            m_seen[i] = m_inputs[i]->m_version;
+        m_checked = m_graph->m_epoch;
+        if (different)
+            changed();
+        return true;
+    }
+    inline void DataflowNode_base::changed()
+    {
+        m_version++;
+        for (DataflowNode_base* dep : m_dependents)
+            m_graph->enqueue(*dep);
+        notify();
+    }
+
+    inline void DataflowNode_base::sourceChanged()
+    {
+        m_graph->m_epoch++;
+        m_checked = m_graph->m_epoch;
+        changed();
+    }
+
+    template<class Ty>
+    class DataflowNode :public DataflowNode_base //带有值的数据流节点
+    {
+    public:
+        Delegate_view<void, const Ty&> OnChanged = m_changed;
+
+        //拉取最新的值
+        const Ty& Get()
+        {
+            ensure();
+            return m_value;
+        }
+        //不计算，直接返回当前保存的值
+        const Ty& Peek()const noexcept
+        {
+            return m_value;
+        }
+
+    protected:
+        DataflowNode(DataflowGraph& graph, const Ty& value)
+            :DataflowNode_base(graph), m_value(value)
+        {
+        }
+        void notify()override
+        {
+            m_changed(m_value);
+        }
+
+        Ty m_value;
+        Delegate<void, const Ty&> m_changed;
+    };
+
+    template<class Ty>
+    class Source :public DataflowNode<Ty> //源节点
+    {
+    public:
+        Source(DataflowGraph& graph, const Ty& value = Ty())
+            :DataflowNode<Ty>(graph, value)
+        {
+        }
+
+        //新值与旧值不相等时才标记依赖的节点，返回值是否改变
+        bool Set(const Ty& value)
+        {
+            if (this->m_value == value)
+                return false;
+            this->m_value = value;
+            this->sourceChanged();
+            return true;
+        }
+        Source& operator=(const Ty& value)
+        {
+            Set(value);
+            return *this;
+        }
+    };
+
+    template<class Ty, class...Ty_inputs>
+    class Computed :public DataflowNode<Ty> //计算节点
+    {
+    public:
+        using ComputeFun = DelegateSingle<Ty, const Ty_inputs&...>;
+
+        Computed(DataflowGraph& graph, const ComputeFun& fun, DataflowNode<Ty_inputs>&... inputs)
+            :DataflowNode<Ty>(graph, fun(inputs.Get()...)), m_fun(fun), m_args(&inputs...)
+        {
+            (this->addInput(inputs), ...);
+        }
+
+    protected:
+        bool evaluate()override
+        {
+            Ty value = std::apply([this](auto*... inputs) { return m_fun(inputs->Peek()...); }, m_args);
+            if (value == this->m_value)
+                return false;
+            this->m_value = std::move(value);
+            return true;
+        }
+
+        ComputeFun m_fun;
+        std::tuple<DataflowNode<Ty_inputs>*...> m_args;
+    };
+}
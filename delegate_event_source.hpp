@@ -0,0 +1,154 @@
+/*
+    与 epoll 等反应器循环集成的事件源
+    用法示例:
+        Delegate<void,int> onData;
+        EventSource<int> source(onData);            //在反应器线程中构造（或调用 BindThread）
+        epoll_event ev{ EPOLLIN };
+        ev.data.ptr = &source;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, source.NativeHandle(), &ev);
+        ...
+        source.Raise(42);                           //任意线程调用，参数进入无锁队列
+        ...
+        //反应器线程中 fd 可读时
+        static_cast<EventSource<int>*>(ev.data.ptr)->OnReadable();   //批量调用 onData
+
+    其他:
+        1、Linux 下使用 eventfd，Windows 下使用自动重置的事件对象（可用于 WaitForMultipleObjects），
+           NativeHandle 返回对应的句柄。
+        2、在反应器取出队列之前，多次 Raise 只会通知一次句柄，避免每次 Raise 都进行系统调用。
+           GetRaisedCount 和 GetSignalCount 分别返回 Raise 的次数和实际通知句柄的次数。
+        3、OnReadable 只能在反应器线程中调用。若指定了 maxBatch 且队列中还有剩余，
+           会重新通知句柄，剩余的部分在下一次可读时处理。
+        4、队列的容量和参数大小的限制与 EventLoop 相同（见 delegate_queued.hpp）。
+*/
+#pragma once
+#include<tuple>
+#include<atomic>
+#include<cstdint>
+#include<system_error>
+#include"delegate_queued.hpp"
+#if defined(__linux__)
+    #include<unistd.h>
+    #include<sys/eventfd.h>
+#elif defined(_WIN32)
+    #include<windows.h>
+#else
+    #error(delegate_event_source.hpp：只支持 Linux 和 Windows)
+#endif
+
+namespace MyCodes
+{
+    template<class...Ty_params>
+    class EventSource //跨线程事件源
+    {
+    public:
+        using DelegateType = Delegate<void, Ty_params...>;
+    #if defined(__linux__)
+        using native_handle_type = int;
+    #else
+        using native_handle_type = HANDLE;
+    #endif
+
+        EventSource(DelegateType& del, size_t capacity = 1024)
+            :m_loop(capacity)
+        {
+            m_del = &del;
+        #if defined(__linux__)
+            m_handle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (m_handle < 0)
+                throw std::system_error(errno, std::system_category(), "eventfd");
+        #else
+            m_handle = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+            if (m_handle == nullptr)
+                throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "CreateEvent");
+        #endif
+        }
+        EventSource(const EventSource&) = delete;
+        EventSource& operator=(const EventSource&) = delete;
+        ~EventSource()
+        {
+        #if defined(__linux__)
+            close(m_handle);
+        #else
+            CloseHandle(m_handle);
+        #endif
+        }
+
+        native_handle_type NativeHandle()const noexcept
+        {
+            return m_handle;
+        }
+        //把当前线程设置为反应器线程
+        void BindThread()noexcept
+        {
+            m_loop.BindThread();
+        }
+
+        //任意线程调用，参数进入队列，必要时通知句柄
+        void Raise(const Ty_params&... params)
+        {
+            m_raised.fetch_add(1, std::memory_order_relaxed);
+            m_loop.Post([del = m_del, args = std::tuple<std::decay_t<Ty_params>...>(params...)]()
+            {
+                std::apply([del](const auto&... _args) { del->Invoke(_args...); }, args);
+            });
+            if (!m_signaled.exchange(true))
+                signal();
+        }
+        void operator()(const Ty_params&... params)
+        {
+            Raise(params...);
+        }
+
+        //句柄可读时在反应器线程中调用，返回调用的次数
+        size_t OnReadable(size_t maxBatch = SIZE_MAX)
+        {
+            reset();
+            //先清除通知标记再取队列，在此之后入队的参数会重新通知句柄。必须是读改写操作：
+            //Raise 的 exchange 读到 true 时，这里的 exchange 一定读到它写入的值并与之同步，
+            //之后的 Drain 能看到它之前入队的参数；单纯的 store 可能被重排到 Drain 的读取之后
+            m_signaled.exchange(false);
+            const size_t count = m_loop.Drain(maxBatch);
+            if (count == maxBatch && !m_signaled.exchange(true))
+                signal();
+            return count;
+        }
+
+        size_t GetRaisedCount()const noexcept
+        {
+            return m_raised.load(std::memory_order_relaxed);
+        }
+        size_t GetSignalCount()const noexcept
+        {
+            return m_signals.load(std::memory_order_relaxed);
+        }
+
+    protected:
+        void signal()noexcept
+        {
+            m_signals.fetch_add(1, std::memory_order_relaxed);
+        #if defined(__linux__)
+            const uint64_t one = 1;
+            (void)!write(m_handle, &one, sizeof(one));
+        #else
+            SetEvent(m_handle);
+        #endif
+        }
+        void reset()noexcept
+        {
+        #if defined(__linux__)
+            uint64_t value;
+            (void)!read(m_handle, &value, sizeof(value));
+        #else
+            ResetEvent(m_handle);
+        #endif
+        }
+
+        DelegateType* m_del;
+        EventLoop m_loop;
+        native_handle_type m_handle;
+        alignas(64) std::atomic<bool> m_signaled{ false };
+        std::atomic<size_t> m_raised{ 0 };
+        std::atomic<size_t> m_signals{ 0 };
+    };
+}
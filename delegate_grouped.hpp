@@ -0,0 +1,232 @@
+/*
+    带分组的多播委托，可以整组地静音和恢复订阅者
+    用法示例:
+        enum Groups { gameplay = 0, debug_overlay = 1, telemetry = 2 };
+        GroupedDelegate<void,float> onFrame;
+        onFrame.Add({ hud, &Hud::OnFrame });                    //默认加入第 0 组
+        onFrame.Add({ overlay, &Overlay::OnFrame }, debug_overlay);
+        onFrame.Mute(debug_overlay);                            //一次原子操作，不修改订阅者数组
+        onFrame(dt);                                            //跳过 debug_overlay 组
+        onFrame.Unmute(debug_overlay);
+
+    其他:
+        1、最多 64 个组（0 ~ 63），是否静音由一个 64 位的原子掩码表示。Mute、Unmute、SetActiveGroups
+           只修改这个掩码，可以在任意线程中调用，从下一次 Invoke 开始生效。
+        2、所有订阅者存放在同一个数组中，按组号排序，每个组占据一段连续的区间。Invoke 只读取一次
+           掩码，然后只遍历处于活动状态且不为空的组的区间，不需要逐个检查订阅者。
+        3、组内按添加顺序调用，不同组按组号从小到大调用。返回值不为 void 时，返回最后一个被调用
+           的订阅者的返回值；所有订阅者都被静音或没有订阅者时抛出 bad_invoke。
+        4、Add 需要把订阅者插入到对应组的末尾，后面的组整体后移，因此比 Delegate::Add 慢，适合
+           订阅者稳定、静音频繁的场景。调用过程中 Add、Sub 是安全的，但本次调用可能会重复调用或
+           跳过其他的订阅者。除掩码以外，订阅者数组不是线程安全的。
+*/
+#pragma once
+#include<atomic>
+#include<vector>
+#include<cstdint>
+#include<iterator>
+#include<algorithm>
+#include"delegate.hpp"
+#if MYCODES_DELEGATE_LANG < 201703L
+#error(delegate_grouped.hpp：请使用c++17及以上的版本)
+#endif
+
+namespace MyCodes
+{
+    template<class Ty_ret, class...Ty_params>
+    class GroupedDelegate //带分组的多播委托
+    {
+    public:
+        using DelegateSingle_Type = DelegateSingle<Ty_ret, Ty_params...>;
+        static constexpr size_t group_count = 64;
+
+        GroupedDelegate() = default;
+        GroupedDelegate(const GroupedDelegate& right)
+            :m_dels(right.m_dels), m_active(right.m_active.load(std::memory_order_relaxed)), m_nonEmpty(right.m_nonEmpty)
+        {
+            std::copy(std::begin(right.m_begin), std::end(right.m_begin), std::begin(m_begin));
+        }
+        GroupedDelegate& operator=(const GroupedDelegate&) = delete;
+
+        //把委托添加到 group 组的末尾
+        void Add(const DelegateSingle_Type& del, size_t group = 0)
+        {
+            if (del.IsNull() || group >= group_count)
+                return;
+            m_dels.insert(m_dels.begin() + m_begin[group + 1], del);
+            for (size_t i = group + 1; i <= group_count; i++)
+                m_begin[i]++;
+            m_nonEmpty |= uint64_t(1) << group;
+        }
+        GroupedDelegate& operator+=(const DelegateSingle_Type& del)
+        {
+            Add(del);
+            return *this;
+        }
+
+        //从 group 组中删除最后一个与 del 相等的委托
+        bool Sub(const DelegateSingle_Type& del, size_t group)
+        {
+            if (group >= group_count)
+                return false;
+            for (size_t i = m_begin[group + 1]; i > m_begin[group]; i--)
+            {
+                if (m_dels[i - 1] == del)
+                {
+                    eraseAt(i - 1, group);
+                    return true;
+                }
+            }
+            return false;
+        }
+        //从所有组中删除最后一个与 del 相等的委托
+        bool Sub(const DelegateSingle_Type& del)
+        {
+            for (size_t group = group_count; group > 0; group--)
+            {
+                if (Sub(del, group - 1))
+                    return true;
+            }
+            return false;
+        }
+        bool operator-=(const DelegateSingle_Type& del)
+        {
+            return Sub(del);
+        }
+        bool Have(const DelegateSingle_Type& del)const noexcept
+        {
+            return haveDelegate(del, m_dels);
+        }
+        //删除 group 组中的所有委托
+        void ClearGroup(size_t group)
+        {
+            if (group >= group_count)
+                return;
+            const size_t count = m_begin[group + 1] - m_begin[group];
+            m_dels.erase(m_dels.begin() + m_begin[group], m_dels.begin() + m_begin[group + 1]);
+            for (size_t i = group + 1; i <= group_count; i++)
+                m_begin[i] -= static_cast<uint32_t>(count);
+            m_nonEmpty &= ~(uint64_t(1) << group);
+        }
+        void Clear()noexcept
+        {
+            m_dels.clear();
+            std::fill(std::begin(m_begin), std::end(m_begin), 0);
+            m_nonEmpty = 0;
+        }
+        bool Empty()const noexcept
+        {
+            return m_dels.empty();
+        }
+        size_t getsize()const noexcept
+        {
+            return m_dels.size();
+        }
+        size_t GroupSize(size_t group)const noexcept
+        {
+            return group < group_count ? m_begin[group + 1] - m_begin[group] : 0;
+        }
+
+        //静音和恢复，只修改活动组的掩码
+        void Mute(size_t group)noexcept
+        {
+            if (group < group_count)
+                m_active.fetch_and(~(uint64_t(1) << group), std::memory_order_relaxed);
+        }
+        void Unmute(size_t group)noexcept
+        {
+            if (group < group_count)
+                m_active.fetch_or(uint64_t(1) << group, std::memory_order_relaxed);
+        }
+        bool IsMuted(size_t group)const noexcept
+        {
+            return group >= group_count || (m_active.load(std::memory_order_relaxed) & (uint64_t(1) << group)) == 0;
+        }
+        void SetActiveGroups(uint64_t mask)noexcept
+        {
+            m_active.store(mask, std::memory_order_relaxed);
+        }
+        uint64_t GetActiveGroups()const noexcept
+        {
+            return m_active.load(std::memory_order_relaxed);
+        }
+
+        //只调用活动组中的委托
+        Ty_ret Invoke(const Ty_params&... params)const
+        {
+            uint64_t groups = m_active.load(std::memory_order_relaxed) & m_nonEmpty;
+            if constexpr (std::is_void_v<Ty_ret>)
+            {
+                for (; groups != 0; groups &= groups - 1)
+                    invokeGroup(lowestGroup(groups), params...);
+            }
+            else
+            {
+                if (groups == 0)
+                    throwBadInvoke();
+                const size_t last = highestGroup(groups);
+                for (groups &= ~(uint64_t(1) << last); groups != 0; groups &= groups - 1)
+                    invokeGroup(lowestGroup(groups), params...);
+                //最后一组的最后一个委托提供返回值，调用过程中该组可能被清空
+                size_t i = m_begin[last];
+                for (; i + 1 < m_begin[last + 1]; i++)
+                    m_dels[i].InvokeUnchecked(params...);
+                if (i >= m_begin[last + 1])
+                    throwBadInvoke();
+                return m_dels[i].InvokeUnchecked(params...);
+            }
+        }
+        Ty_ret operator()(const Ty_params&... params)const
+        {
+            return Invoke(params...);
+        }
+        bool TryInvoke(const Ty_params&... params)const
+        {
+            uint64_t groups = m_active.load(std::memory_order_relaxed) & m_nonEmpty;
+            if (groups == 0)
+                return false;
+            for (; groups != 0; groups &= groups - 1)
+                invokeGroup(lowestGroup(groups), params...);
+            return true;
+        }
+
+    protected:
+        static size_t lowestGroup(uint64_t groups)noexcept
+        {
+            size_t group = 0;
+            while ((groups & 1) == 0)
+            {
+                groups >>= 1;
+                group++;
+            }
+            return group;
+        }
+        static size_t highestGroup(uint64_t groups)noexcept
+        {
+            size_t group = 0;
+            while (groups >>= 1)
+                group++;
+            return group;
+        }
+
+        void invokeGroup(size_t group, const Ty_params&... params)const
+        {
+            //调用过程中数组和区间都可能改变，每次都重新读取
+            for (size_t i = m_begin[group]; i < m_begin[group + 1]; i++)
+                m_dels[i].InvokeUnchecked(params...);
+        }
+        void eraseAt(size_t index, size_t group)
+        {
+            m_dels.erase(m_dels.begin() + index);
+            for (size_t i = group + 1; i <= group_count; i++)
+                m_begin[i]--;
+            if (m_begin[group] == m_begin[group + 1])
+                m_nonEmpty &= ~(uint64_t(1) << group);
+        }
+
+        std::vector<DelegateSingle_Type> m_dels;    //按组号排序
+        uint32_t m_begin[group_count + 1]{};        //第 i 组的区间为 [m_begin[i], m_begin[i + 1])
+        std::atomic<uint64_t> m_active{ ~uint64_t(0) };
+        uint64_t m_nonEmpty = 0;                    //不为空的组
+    };
+}
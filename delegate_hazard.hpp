@@ -0,0 +1,160 @@
+/*
+    危险指针（hazard pointer），供需要无锁读取快照的委托使用
+    用法示例:
+        std::atomic<const Pool*> m_pool;                    //当前快照，只由持有互斥锁的写入方替换
+        std::vector<const Pool*> m_retired;                 //被替换、可能仍有读取方使用的快照
+
+        delegate_hazard::Guard<Pool> pool(m_pool);          //读取方：声明后再使用 *pool
+        m_retired.push_back(m_pool.exchange(next));         //写入方：替换快照
+        delegate_hazard::Reclaim(m_retired);                //释放没有读取方使用的旧快照
+
+    其他:
+        1、读取快照时只有一次写入本线程记录的原子存储，没有引用计数的原子读改写，多个读取
+           线程之间不会争抢同一个缓存行。
+        2、每个线程第一次读取时会分配一个记录（所有使用危险指针的对象共用），记录只会加入
+           链表，不会删除，线程结束后供其他线程复用。
+        3、Reclaim 需要由唯一的写入方（通常持有互斥锁）调用，析构时不能有正在进行的读取。
+*/
+#pragma once
+#include<atomic>
+#include<vector>
+#include<algorithm>
+#include"delegate.hpp"
+#if MYCODES_DELEGATE_LANG < 201703L
+#error(delegate_hazard.hpp：请使用c++17及以上的版本)
+#endif
+
+namespace MyCodes
+{
+    class delegate_hazard //危险指针：读取方声明正在使用的对象，写入方只释放没有被声明的对象
+    {
+    public:
+        struct Record
+        {
+            std::atomic<const void*> ptr{ nullptr };
+            std::atomic<bool> used{ false };
+            Record* next = nullptr;
+        };
+
+        //取得一个记录，优先使用本线程缓存的记录，可以嵌套使用
+        static Record* Acquire()
+        {
+            Cache& cache = local();
+            if (cache.count != 0)
+                return cache.records[--cache.count];
+
+            for (Record* rec = head().load(std::memory_order_acquire); rec != nullptr; rec = rec->next)
+            {
+                bool expected = false;
+                if (!rec->used.load(std::memory_order_relaxed) &&
+                    rec->used.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                    return rec;
+            }
+            //记录只会加入链表，不会删除
+            Record* rec = new Record();
+            rec->used.store(true, std::memory_order_relaxed);
+            Record* old = head().load(std::memory_order_relaxed);
+            do
+            {
+                rec->next = old;
+            } while (!head().compare_exchange_weak(old, rec, std::memory_order_release, std::memory_order_relaxed));
+            return rec;
+        }
+        static void Release(Record* rec)noexcept
+        {
+            rec->ptr.store(nullptr, std::memory_order_release);
+            Cache& cache = local();
+            if (cache.count < cache_size)
+                cache.records[cache.count++] = rec;
+            else
+                rec->used.store(false, std::memory_order_release);
+        }
+        //是否有读取方正在使用 p
+        static bool Protected(const void* p)noexcept
+        {
+            for (Record* rec = head().load(std::memory_order_acquire); rec != nullptr; rec = rec->next)
+            {
+                if (rec->ptr.load(std::memory_order_seq_cst) == p)
+                    return true;
+            }
+            return false;
+        }
+        //释放 retired 中没有读取方使用的对象，需要由唯一的写入方调用
+        template<class Ty>
+        static void Reclaim(std::vector<const Ty*>& retired)
+        {
+            retired.erase(std::remove_if(retired.begin(), retired.end(), [](const Ty* p)
+                {
+                    if (Protected(p))
+                        return false;
+                    delete p;
+                    return true;
+                }), retired.end());
+        }
+
+        //读取 source 指向的对象：声明危险指针后再次确认没有被替换，之后写入方不会释放它
+        template<class Ty>
+        class Guard
+        {
+        public:
+            Guard(const std::atomic<const Ty*>& source)
+                :m_record(Acquire())
+            {
+                const Ty* p = source.load(std::memory_order_relaxed);
+                for (;;)
+                {
+                    m_record->ptr.store(p, std::memory_order_seq_cst);
+                    const Ty* current = source.load(std::memory_order_seq_cst);
+                    if (current == p)
+                        break;
+                    p = current;
+                }
+                m_ptr = p;
+            }
+            Guard(const Guard&) = delete;
+            Guard& operator=(const Guard&) = delete;
+            ~Guard()
+            {
+                Release(m_record);
+            }
+            const Ty& operator*()const noexcept
+            {
+                return *m_ptr;
+            }
+            const Ty* operator->()const noexcept
+            {
+                return m_ptr;
+            }
+
+        private:
+            Record* m_record;
+            const Ty* m_ptr;
+        };
+
+    private:
+        static constexpr size_t cache_size = 4;
+
+        struct Cache
+        {
+            //线程结束时把缓存的记录交给其他线程使用
+            ~Cache()
+            {
+                for (size_t i = 0; i < count; i++)
+                    records[i]->used.store(false, std::memory_order_release);
+            }
+            Record* records[cache_size];
+            size_t count = 0;
+        };
+
+        static std::atomic<Record*>& head()noexcept
+        {
+            static std::atomic<Record*> _head{ nullptr };
+            return _head;
+        }
+        static Cache& local()noexcept
+        {
+            thread_local Cache _cache;
+            return _cache;
+        }
+    };
+}
@@ -0,0 +1,277 @@
+/*
+    侵入式多播委托，订阅者析构时自动 O(1) 删除
+    用法示例:
+        IntrusiveDelegate<void,int> onDamage;
+        class Enemy
+        {
+        public:
+            Enemy(IntrusiveDelegate<void,int>& ev)
+            {
+                ev.Add(m_onDamage, *this, &Enemy::OnDamage);    //把连接节点链接到委托中，不分配内存
+            }
+            void OnDamage(int value);
+        private:
+            Connection<void,int> m_onDamage;                    //Enemy 析构时自动从委托中移除
+        };
+        onDamage(10);
+
+    其他:
+        1、Connection 是嵌入在订阅者中的链表节点，内部保存一个 DelegateSingle。Add 把节点链接到
+           委托的链表末尾，不分配内存；Connection 析构（或调用 Disconnect）时在 O(1) 时间内从
+           链表中移除，订阅者不需要记住自己加入了哪些委托，也不会留下悬空的 this 指针。
+        2、一个 Connection 同一时间只能连接到一个委托，再次 Add 时会先断开原来的连接。复制订阅者时
+           Connection 不会被复制，新对象的 Connection 处于未连接状态。
+        3、Invoke 遍历的是按链表顺序构建的连续数组，只有 Add 之后才会在下一次 Invoke 时重建。
+           Disconnect 只把数组中对应的位置置空，不需要重建；空位超过一半时在下一次 Invoke 时压缩。
+        4、调用过程中可以 Add、Disconnect，也可以析构尚未被调用的订阅者，被断开的订阅者在本次
+           调用中不会再被调用，新加入的订阅者从下一次调用开始生效。
+        5、IntrusiveDelegate 析构时会断开所有连接。两者都不是线程安全的。
+*/
+#pragma once
+#include<vector>
+#include<cstdint>
+#include"delegate.hpp"
+#if MYCODES_DELEGATE_LANG < 201703L
+#error(delegate_intrusive.hpp：请使用c++17及以上的版本)
+#endif
+
+namespace MyCodes
+{
+    template<class Ty_ret, class...Ty_params>
+    class IntrusiveDelegate;
+
+    template<class Ty_ret, class...Ty_params>
+    class Connection //嵌入在订阅者中的连接节点
+    {
+        friend class IntrusiveDelegate<Ty_ret, Ty_params...>;
+    public:
+        using DelegateSingle_Type = DelegateSingle<Ty_ret, Ty_params...>;
+
+        Connection() = default;
+        //复制得到的连接不与任何委托连接
+        Connection(const Connection&)noexcept
+        {
+        }
+        Connection& operator=(const Connection&)noexcept
+        {
+            return *this;
+        }
+        ~Connection()
+        {
+            Disconnect();
+        }
+
+        void Disconnect()noexcept
+        {
+            if (m_owner != nullptr)
+                m_owner->unlink(*this);
+        }
+        bool IsConnected()const noexcept
+        {
+            return m_owner != nullptr;
+        }
+        const DelegateSingle_Type& GetDelegate()const noexcept
+        {
+            return m_del;
+        }
+
+    protected:
+        static constexpr size_t npos = SIZE_MAX;
+
+        DelegateSingle_Type m_del;
+        IntrusiveDelegate<Ty_ret, Ty_params...>* m_owner = nullptr;
+        Connection* m_prev = nullptr;
+        Connection* m_next = nullptr;
+        size_t m_index = npos;  //在调用数组中的位置，不在数组中时为 npos
+    };
+
+    template<class Ty_ret, class...Ty_params>
+    class IntrusiveDelegate //侵入式多播委托
+    {
+        friend class Connection<Ty_ret, Ty_params...>;
+    public:
+        using Connection_Type = Connection<Ty_ret, Ty_params...>;
+        using DelegateSingle_Type = DelegateSingle<Ty_ret, Ty_params...>;
+
+        IntrusiveDelegate() = default;
+        IntrusiveDelegate(const IntrusiveDelegate&) = delete;
+        IntrusiveDelegate& operator=(const IntrusiveDelegate&) = delete;
+        ~IntrusiveDelegate()
+        {
+            Clear();
+        }
+
+        //把 conn 链接到链表末尾，conn 已经连接到其他委托时会先断开
+        void Add(Connection_Type& conn, const DelegateSingle_Type& del)noexcept
+        {
+            conn.Disconnect();
+            if (del.IsNull())
+                return;
+            conn.m_del = del;
+            conn.m_owner = this;
+            conn.m_prev = m_tail;
+            conn.m_next = nullptr;
+            conn.m_index = Connection_Type::npos;
+            if (m_tail != nullptr)
+                m_tail->m_next = &conn;
+            else
+                m_head = &conn;
+            m_tail = &conn;
+            m_count++;
+            m_dirty = true;
+        }
+        template<class...Args>
+        void Add(Connection_Type& conn, const Args&... args)noexcept
+        {
+            DelegateSingle_Type temp;
+            temp.Bind(args...);
+            Add(conn, temp);
+        }
+
+        //断开所有连接
+        void Clear()noexcept
+        {
+            for (Connection_Type* conn = m_head; conn != nullptr;)
+            {
+                Connection_Type* next = conn->m_next;
+                conn->m_owner = nullptr;
+                conn->m_prev = nullptr;
+                conn->m_next = nullptr;
+                conn->m_index = Connection_Type::npos;
+                conn = next;
+            }
+            m_head = nullptr;
+            m_tail = nullptr;
+            m_count = 0;
+            for (auto& del : m_cache)
+                del.UnBind();
+            m_holes = m_cache.size();
+            m_dirty = true;
+        }
+        bool Empty()const noexcept
+        {
+            return m_count == 0;
+        }
+        size_t getsize()const noexcept
+        {
+            return m_count;
+        }
+
+        //触发调用
+        Ty_ret Invoke(const Ty_params&... params)
+        {
+            if (m_dispatching == 0 && (m_dirty || m_holes * 2 > m_cache.size()))
+                rebuild();
+
+            Dispatch_guard guard(m_dispatching);
+            //调用过程中不会重建数组，Add 只影响下一次调用，Disconnect 只会把对应的位置置空
+            const size_t count = m_cache.size();
+            if constexpr (std::is_void_v<Ty_ret>)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    if (!m_cache[i].IsNull())
+                        m_cache[i].InvokeUnchecked(params...);
+                }
+            }
+            else
+            {
+                size_t last = count;
+                while (last > 0 && m_cache[last - 1].IsNull())
+                    last--;
+                if (last == 0)
+                    throwBadInvoke();
+                for (size_t i = 0; i + 1 < last; i++)
+                {
+                    if (!m_cache[i].IsNull())
+                        m_cache[i].InvokeUnchecked(params...);
+                }
+                //前面的委托可能断开了最后一个委托
+                if (m_cache[last - 1].IsNull())
+                    throwBadInvoke();
+                return m_cache[last - 1].InvokeUnchecked(params...);
+            }
+        }
+        Ty_ret operator()(const Ty_params&... params)
+        {
+            return Invoke(params...);
+        }
+        bool TryInvoke(const Ty_params&... params)
+        {
+            if (Empty())
+                return false;
+            if constexpr (std::is_void_v<Ty_ret>)
+                Invoke(params...);
+            else
+            {
+                if (m_dispatching == 0 && (m_dirty || m_holes * 2 > m_cache.size()))
+                    rebuild();
+                Dispatch_guard guard(m_dispatching);
+                for (size_t i = 0; i < m_cache.size(); i++)
+                {
+                    if (!m_cache[i].IsNull())
+                        m_cache[i].InvokeUnchecked(params...);
+                }
+            }
+            return true;
+        }
+
+    protected:
+        struct Dispatch_guard
+        {
+            Dispatch_guard(size_t& depth)noexcept
+                :depth(depth)
+            {
+                depth++;
+            }
+            ~Dispatch_guard()
+            {
+                depth--;
+            }
+            size_t& depth;
+        };
+
+        void unlink(Connection_Type& conn)noexcept
+        {
+            if (conn.m_prev != nullptr)
+                conn.m_prev->m_next = conn.m_next;
+            else
+                m_head = conn.m_next;
+            if (conn.m_next != nullptr)
+                conn.m_next->m_prev = conn.m_prev;
+            else
+                m_tail = conn.m_prev;
+            if (conn.m_index != Connection_Type::npos)
+            {
+                m_cache[conn.m_index].UnBind();
+                m_holes++;
+            }
+            conn.m_owner = nullptr;
+            conn.m_prev = nullptr;
+            conn.m_next = nullptr;
+            conn.m_index = Connection_Type::npos;
+            m_count--;
+        }
+        //按链表顺序重建调用数组
+        void rebuild()
+        {
+            m_cache.clear();
+            m_cache.reserve(m_count);
+            for (Connection_Type* conn = m_head; conn != nullptr; conn = conn->m_next)
+            {
+                conn->m_index = m_cache.size();
+                m_cache.push_back(conn->m_del);
+            }
+            m_holes = 0;
+            m_dirty = false;
+        }
+
+        Connection_Type* m_head = nullptr;
+        Connection_Type* m_tail = nullptr;
+        size_t m_count = 0;
+        std::vector<DelegateSingle_Type> m_cache;   //按链表顺序排列的调用数组
+        size_t m_holes = 0;                         //调用数组中被置空的数量
+        size_t m_dispatching = 0;                   //正在进行的调用的层数
+        bool m_dirty = false;
+    };
+}
@@ -0,0 +1,568 @@
+/*
+    基于内存映射文件的事件调用记录与回放
+    用法示例:
+        //记录
+        EventJournal journal("events.journal");         //创建（覆盖）日志文件，默认大小 64MB
+        journal.Record(onTick, 1);                      //之后 onTick 的每次调用都会记录到日志中
+        journal.Record(onOrder, 2);
+        ...
+        journal.Stop(1);                                //停止记录 onTick
+
+        //回放
+        JournalReplayer replay("events.journal");
+        replay.Bind(1, onTick);                         //把 id 1 的记录回放到 onTick
+        replay.Bind(2, onOrder);
+        replay.Run();                                   //全速回放
+        replay.Run(JournalReplayer::timed, 0.5);        //按原始的时间间隔以 0.5 倍速回放
+
+    其他:
+        1、只能记录返回值为 void 的多播委托，参数需要可以平凡复制。Record 向委托中添加一个
+           记录用的委托（只在此时分配内存），委托被调用时把时间戳、id 和参数写入日志。
+           回放时参数按相同的顺序和类型读出，Bind 的委托签名需要与记录时相同。参数为非 const
+           引用时记录的是引用的值，回放时传入的是该值的副本，对它的修改不会写回日志。
+        2、日志文件在创建时按指定大小预先分配并映射到内存，分为固定大小的段。每个线程第一次
+           记录时通过原子操作领取一个段，之后只写入自己的段，段写满后再领取下一个段，记录时
+           既不加锁也不分配内存。所有段都用完后新的记录会被丢弃，丢弃的数量可以通过
+           GetDroppedCount 查询。单条记录的大小不能超过段的大小。
+        3、每个段内的记录按时间顺序排列，回放时按时间戳合并所有段，同一时间戳的记录顺序不确定。
+           记录到一半的日志也可以回放，只会读到已经完整写入的记录。
+        4、时间戳为 steady_clock 的纳秒数，只用于计算记录之间的时间间隔。
+        5、EventJournal 析构时会从所有仍在记录的委托中删除记录用的委托，需要保证这些委托的
+           生命周期长于 EventJournal，或者提前调用 Stop。
+        6、Linux 等 POSIX 系统下使用 mmap，Windows 下使用 CreateFileMapping。
+*/
+#pragma once
+#include<atomic>
+#include<chrono>
+#include<memory>
+#include<thread>
+#include<vector>
+#include<cstdint>
+#include<cstring>
+#include<algorithm>
+#include<stdexcept>
+#include<system_error>
+#include<type_traits>
+#include<unordered_map>
+#include"delegate.hpp"
+#if MYCODES_DELEGATE_LANG < 201703L
+#error(delegate_journal.hpp：请使用c++17及以上的版本)
+#endif
+#if defined(_WIN32)
+    #include<windows.h>
+#else
+    #include<fcntl.h>
+    #include<unistd.h>
+    #include<sys/mman.h>
+    #include<sys/stat.h>
+#endif
+
+namespace MyCodes
+{
+    class journal_mapping //映射到内存的文件
+    {
+    public:
+        //创建（覆盖）大小为 size 的文件并以读写方式映射，size 为 0 时以只读方式映射已有的文件
+        journal_mapping(const char* path, size_t size)
+        {
+        #if defined(_WIN32)
+            const bool write = size != 0;
+            m_file = CreateFileA(path, write ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                nullptr, write ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (m_file == INVALID_HANDLE_VALUE)
+                throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "CreateFile");
+            if (!write)
+            {
+                LARGE_INTEGER fileSize;
+                if (!GetFileSizeEx(m_file, &fileSize))
+                    throwLast("GetFileSizeEx");
+                size = static_cast<size_t>(fileSize.QuadPart);
+            }
+            m_mapping = CreateFileMappingA(m_file, nullptr, write ? PAGE_READWRITE : PAGE_READONLY,
+                static_cast<DWORD>(uint64_t(size) >> 32), static_cast<DWORD>(size), nullptr);
+            if (m_mapping == nullptr)
+                throwLast("CreateFileMapping");
+            m_data = MapViewOfFile(m_mapping, write ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+            if (m_data == nullptr)
+                throwLast("MapViewOfFile");
+        #else
+            const bool write = size != 0;
+            m_fd = write ? open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644) : open(path, O_RDONLY | O_CLOEXEC);
+            if (m_fd < 0)
+                throw std::system_error(errno, std::system_category(), "open");
+            if (write)
+            {
+                if (ftruncate(m_fd, static_cast<off_t>(size)) != 0)
+                    throwLast("ftruncate");
+            }
+            else
+            {
+                struct stat st;
+                if (fstat(m_fd, &st) != 0)
+                    throwLast("fstat");
+                size = static_cast<size_t>(st.st_size);
+            }
+            m_data = mmap(nullptr, size, write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, m_fd, 0);
+            if (m_data == MAP_FAILED)
+            {
+                m_data = nullptr;
+                throwLast("mmap");
+            }
+        #endif
+            m_size = size;
+        }
+        journal_mapping(const journal_mapping&) = delete;
+        journal_mapping& operator=(const journal_mapping&) = delete;
+        ~journal_mapping()
+        {
+            release();
+        }
+
+        unsigned char* Data()const noexcept
+        {
+            return static_cast<unsigned char*>(m_data);
+        }
+        size_t Size()const noexcept
+        {
+            return m_size;
+        }
+        //把修改写回文件
+        void Sync()const noexcept
+        {
+        #if defined(_WIN32)
+            FlushViewOfFile(m_data, 0);
+        #else
+            msync(m_data, m_size, MS_ASYNC);
+        #endif
+        }
+
+    protected:
+        void release()noexcept
+        {
+        #if defined(_WIN32)
+            if (m_data != nullptr)
+                UnmapViewOfFile(m_data);
+            if (m_mapping != nullptr)
+                CloseHandle(m_mapping);
+            if (m_file != INVALID_HANDLE_VALUE)
+                CloseHandle(m_file);
+        #else
+            if (m_data != nullptr)
+                munmap(m_data, m_size);
+            if (m_fd >= 0)
+                close(m_fd);
+        #endif
+        }
+        [[noreturn]] void throwLast(const char* what)
+        {
+        #if defined(_WIN32)
+            const int error = static_cast<int>(GetLastError());
+        #else
+            const int error = errno;
+        #endif
+            release();
+            throw std::system_error(error, std::system_category(), what);
+        }
+
+    #if defined(_WIN32)
+        HANDLE m_file = INVALID_HANDLE_VALUE;
+        HANDLE m_mapping = nullptr;
+    #else
+        int m_fd = -1;
+    #endif
+        void* m_data = nullptr;
+        size_t m_size = 0;
+    };
+
+    struct journal_format //日志文件的格式
+    {
+        static constexpr uint32_t magic = 0x4C4E4A44;   //"DJNL"
+        static constexpr uint32_t version = 1;
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t segmentSize;
+            uint64_t segmentCount;
+            std::atomic<uint64_t> claimed;      //已经领取的段的数量
+            std::atomic<uint64_t> dropped;      //因为没有空闲的段而丢弃的记录数量
+            unsigned char reserved[24];
+        };
+        struct Segment
+        {
+            std::atomic<uint64_t> used;         //已经完整写入的字节数（不包括段头）
+            uint64_t reserved;
+        };
+        struct Record
+        {
+            uint64_t timestamp;
+            uint32_t id;
+            uint32_t size;                      //参数的字节数
+        };
+
+        static_assert(sizeof(Header) == 64, "journal_format：文件头的大小不正确");
+
+        static size_t align(size_t size)noexcept
+        {
+            return (size + 7) / 8 * 8;
+        }
+        template<class...Ty_params>
+        static constexpr size_t argsSize()noexcept
+        {
+            return (size_t(0) + ... + sizeof(std::decay_t<Ty_params>));
+        }
+    };
+
+    class EventJournal //事件调用记录
+    {
+    public:
+        EventJournal(const char* path, size_t capacity = 64 << 20, size_t segmentSize = 64 << 10)
+            :m_file(path, roundCapacity(capacity, segmentSize))
+        {
+            using Header = journal_format::Header;
+            m_header = reinterpret_cast<Header*>(m_file.Data());
+            m_header->version = journal_format::version;
+            m_header->segmentSize = segmentSize;
+            m_header->segmentCount = (m_file.Size() - sizeof(Header)) / segmentSize;
+            m_header->claimed.store(0, std::memory_order_relaxed);
+            m_header->dropped.store(0, std::memory_order_relaxed);
+            m_header->magic = journal_format::magic;
+            m_id = nextJournalId();
+            m_start = std::chrono::steady_clock::now();
+        }
+        EventJournal(const EventJournal&) = delete;
+        EventJournal& operator=(const EventJournal&) = delete;
+        ~EventJournal()
+        {
+            for (auto& recorder : m_recorders)
+                recorder.second->detach();
+            m_file.Sync();
+        }
+
+        //开始记录 del 的每次调用，id 用于回放时找到对应的委托
+        template<class...Ty_params>
+        void Record(Delegate<void, Ty_params...>& del, uint32_t id)
+        {
+            static_assert((std::is_trivially_copyable_v<std::decay_t<Ty_params>> && ...),
+                "EventJournal：参数需要可以平凡复制");
+            auto& recorder = m_recorders[id];
+            if (recorder != nullptr)
+                throw std::logic_error("EventJournal：同一个 id 已经在记录");
+            auto* typed = new Recorder<Ty_params...>(*this, del, id);
+            recorder.reset(typed);
+            del.Add(*typed, &Recorder<Ty_params...>::Call);
+        }
+        //停止记录 id 对应的委托
+        void Stop(uint32_t id)
+        {
+            auto it = m_recorders.find(id);
+            if (it == m_recorders.end())
+                return;
+            it->second->detach();
+            m_recorders.erase(it);
+        }
+
+        //直接写入一条记录，data 为按顺序排列的参数
+        bool Write(uint32_t id, const void* data, size_t size)noexcept
+        {
+            journal_format::Segment* segment;
+            unsigned char* dest = reserve(sizeof(journal_format::Record) + size, segment);
+            if (dest == nullptr)
+                return false;
+            writeHeader(dest, id, size);
+            std::memcpy(dest + sizeof(journal_format::Record), data, size);
+            commit(segment, sizeof(journal_format::Record) + size);
+            return true;
+        }
+
+        size_t GetDroppedCount()const noexcept
+        {
+            return m_header->dropped.load(std::memory_order_relaxed);
+        }
+        size_t GetUsedSegments()const noexcept
+        {
+            return static_cast<size_t>(std::min<uint64_t>(m_header->claimed.load(std::memory_order_relaxed), m_header->segmentCount));
+        }
+        size_t GetSegmentCount()const noexcept
+        {
+            return static_cast<size_t>(m_header->segmentCount);
+        }
+        void Sync()const noexcept
+        {
+            m_file.Sync();
+        }
+
+    protected:
+        struct Recorder_base
+        {
+            virtual ~Recorder_base() = default;
+            virtual void detach() = 0;
+        };
+        template<class...Ty_params>
+        struct Recorder :Recorder_base
+        {
+            Recorder(EventJournal& journal, Delegate<void, Ty_params...>& del, uint32_t id)noexcept
+                :journal(&journal), del(&del), id(id)
+            {
+            }
+            void Call(Ty_params... params)
+            {
+                constexpr size_t size = journal_format::argsSize<Ty_params...>();
+                journal_format::Segment* segment;
+                unsigned char* dest = journal->reserve(sizeof(journal_format::Record) + size, segment);
+                if (dest == nullptr)
+                    return;
+                journal->writeHeader(dest, id, size);
+                unsigned char* args = dest + sizeof(journal_format::Record);
+                ((std::memcpy(args, &params, sizeof(std::decay_t<Ty_params>)), args += sizeof(std::decay_t<Ty_params>)), ...);
+                journal->commit(segment, sizeof(journal_format::Record) + size);
+            }
+            void detach()override
+            {
+                del->Sub(*this, &Recorder::Call);
+            }
+
+            EventJournal* journal;
+            Delegate<void, Ty_params...>* del;
+            uint32_t id;
+        };
+
+        //每个线程当前写入的段
+        struct ThreadSegment
+        {
+            uint64_t journal = 0;
+            journal_format::Segment* segment = nullptr;
+        };
+        static constexpr size_t thread_cache = 4;
+
+        static size_t roundCapacity(size_t capacity, size_t segmentSize)
+        {
+            if (segmentSize <= sizeof(journal_format::Segment) + sizeof(journal_format::Record))
+                throw std::invalid_argument("EventJournal：段的大小太小");
+            const size_t count = std::max<size_t>(1, (capacity - std::min(capacity, sizeof(journal_format::Header))) / segmentSize);
+            return sizeof(journal_format::Header) + count * segmentSize;
+        }
+        static uint64_t nextJournalId()noexcept
+        {
+            static std::atomic<uint64_t> next{ 1 };
+            return next.fetch_add(1, std::memory_order_relaxed);
+        }
+        static ThreadSegment* threadSegments()noexcept
+        {
+            thread_local ThreadSegment segments[thread_cache];
+            return segments;
+        }
+
+        //在当前线程的段中预留 size 字节，空间不足时领取新的段
+        unsigned char* reserve(size_t size, journal_format::Segment*& reserved)noexcept
+        {
+            using Segment = journal_format::Segment;
+            size = journal_format::align(size);
+            const size_t capacity = m_header->segmentSize - sizeof(Segment);
+            if (size > capacity)
+            {
+                m_header->dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            ThreadSegment* cache = threadSegments();
+            ThreadSegment* slot = nullptr;
+            for (size_t i = 0; i < thread_cache; i++)
+            {
+                if (cache[i].journal == m_id)
+                {
+                    slot = &cache[i];
+                    break;
+                }
+            }
+            if (slot == nullptr)
+            {
+                //缓存中没有当前日志时替换第一个，被替换的日志之后会领取新的段
+                std::move_backward(cache, cache + thread_cache - 1, cache + thread_cache);
+                slot = &cache[0];
+                slot->journal = m_id;
+                slot->segment = nullptr;
+            }
+
+            Segment* segment = slot->segment;
+            if (segment == nullptr || segment->used.load(std::memory_order_relaxed) + size > capacity)
+            {
+                const uint64_t index = m_header->claimed.fetch_add(1, std::memory_order_relaxed);
+                if (index >= m_header->segmentCount)
+                {
+                    slot->segment = nullptr;
+                    m_header->dropped.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+                segment = reinterpret_cast<Segment*>(m_file.Data() + sizeof(journal_format::Header) + index * m_header->segmentSize);
+                segment->used.store(0, std::memory_order_relaxed);
+                slot->segment = segment;
+            }
+            reserved = segment;
+            return reinterpret_cast<unsigned char*>(segment + 1) + segment->used.load(std::memory_order_relaxed);
+        }
+        void writeHeader(unsigned char* dest, uint32_t id, size_t size)const noexcept
+        {
+            journal_format::Record record;
+            record.timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - m_start).count());
+            record.id = id;
+            record.size = static_cast<uint32_t>(size);
+            std::memcpy(dest, &record, sizeof(record));
+        }
+        //记录写入完毕后更新段的长度，回放时只会读到完整的记录
+        void commit(journal_format::Segment* segment, size_t size)noexcept
+        {
+            segment->used.store(segment->used.load(std::memory_order_relaxed) + journal_format::align(size),
+                std::memory_order_release);
+        }
+
+        journal_mapping m_file;
+        journal_format::Header* m_header;
+        uint64_t m_id;
+        std::chrono::steady_clock::time_point m_start;
+        std::unordered_map<uint32_t, std::unique_ptr<Recorder_base>> m_recorders;
+    };
+
+    class JournalReplayer //回放 EventJournal 记录的调用
+    {
+    public:
+        enum Mode
+        {
+            fast,   //全速回放
+            timed   //按记录时的时间间隔回放
+        };
+
+        JournalReplayer(const char* path)
+            :m_file(path, 0)
+        {
+            using Header = journal_format::Header;
+            using Segment = journal_format::Segment;
+            using Record = journal_format::Record;
+            if (m_file.Size() < sizeof(Header))
+                throw std::runtime_error("JournalReplayer：文件不是有效的日志");
+            const Header* header = reinterpret_cast<const Header*>(m_file.Data());
+            if (header->magic != journal_format::magic || header->version != journal_format::version)
+                throw std::runtime_error("JournalReplayer：文件不是有效的日志");
+
+            //依次读取每个段中完整写入的记录，再按时间戳排序
+            const uint64_t segments = std::min(header->claimed.load(std::memory_order_acquire), header->segmentCount);
+            for (uint64_t i = 0; i < segments; i++)
+            {
+                const unsigned char* base = m_file.Data() + sizeof(Header) + i * header->segmentSize;
+                const Segment* segment = reinterpret_cast<const Segment*>(base);
+                const uint64_t used = segment->used.load(std::memory_order_acquire);
+                const unsigned char* data = base + sizeof(Segment);
+                for (uint64_t offset = 0; offset + sizeof(Record) <= used;)
+                {
+                    Record record;
+                    std::memcpy(&record, data + offset, sizeof(record));
+                    m_records.push_back({ record.timestamp, data + offset });
+                    offset += journal_format::align(sizeof(Record) + record.size);
+                }
+            }
+            std::stable_sort(m_records.begin(), m_records.end(),
+                [](const Entry& left, const Entry& right) { return left.timestamp < right.timestamp; });
+        }
+        JournalReplayer(const JournalReplayer&) = delete;
+        JournalReplayer& operator=(const JournalReplayer&) = delete;
+
+        //把 id 对应的记录回放到 del 中，签名需要与记录时相同
+        template<class...Ty_params>
+        void Bind(uint32_t id, const Delegate<void, Ty_params...>& del)
+        {
+            m_targets[id] = { &del, &replayOne<Ty_params...>, journal_format::argsSize<Ty_params...>() };
+        }
+        void Unbind(uint32_t id)
+        {
+            m_targets.erase(id);
+        }
+
+        //回放所有记录，返回调用的次数。timed 模式下 speed 为回放速度的倍数，需要大于 0
+        size_t Run(Mode mode = fast, double speed = 1.0)
+        {
+            if (mode == timed && !(speed > 0))
+                throw std::invalid_argument("JournalReplayer：回放速度需要大于 0");
+            size_t count = 0;
+            if (m_records.empty())
+                return 0;
+            const auto start = std::chrono::steady_clock::now();
+            const uint64_t first = m_records.front().timestamp;
+            //速度很小时间隔可能超出 time_point 的范围，此时只等待到最大值
+            const auto maxWait = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::time_point::max() - start);
+            for (const Entry& entry : m_records)
+            {
+                if (mode == timed)
+                {
+                    const double delay = static_cast<double>(entry.timestamp - first) / speed;
+                    const auto wait = delay < static_cast<double>(maxWait.count()) ?
+                        std::chrono::nanoseconds(static_cast<int64_t>(delay)) : maxWait;
+                    std::this_thread::sleep_until(start + wait);
+                }
+                count += invoke(entry);
+            }
+            return count;
+        }
+
+        size_t GetRecordCount()const noexcept
+        {
+            return m_records.size();
+        }
+        //记录的时间跨度（纳秒）
+        uint64_t GetDuration()const noexcept
+        {
+            return m_records.empty() ? 0 : m_records.back().timestamp - m_records.front().timestamp;
+        }
+
+    protected:
+        struct Entry
+        {
+            uint64_t timestamp;
+            const unsigned char* record;
+        };
+        struct Target
+        {
+            const void* del;
+            void(*replay)(const void* del, const unsigned char* args);
+            size_t size;
+        };
+
+        //参数先复制到局部变量中，签名中的非 const 引用参数绑定到这些副本上
+        template<size_t I, class...Ty_params, class...Ty_done>
+        static void replayArgs(const Delegate<void, Ty_params...>& del, const unsigned char* args, Ty_done&... done)
+        {
+            if constexpr (I == sizeof...(Ty_params))
+            {
+                del.Invoke(done...);
+            }
+            else
+            {
+                using Arg = std::decay_t<std::tuple_element_t<I, std::tuple<Ty_params...>>>;
+                alignas(Arg) unsigned char buffer[sizeof(Arg)];
+                std::memcpy(buffer, args, sizeof(Arg));
+                replayArgs<I + 1>(del, args + sizeof(Arg), done..., *reinterpret_cast<Arg*>(buffer));
+            }
+        }
+        template<class...Ty_params>
+        static void replayOne(const void* del, const unsigned char* args)
+        {
+            replayArgs<0>(*static_cast<const Delegate<void, Ty_params...>*>(del), args);
+        }
+
+        bool invoke(const Entry& entry)const
+        {
+            journal_format::Record record;
+            std::memcpy(&record, entry.record, sizeof(record));
+            auto it = m_targets.find(record.id);
+            if (it == m_targets.end() || it->second.size != record.size)
+                return false;
+            it->second.replay(it->second.del, entry.record + sizeof(record));
+            return true;
+        }
+
+        journal_mapping m_file;
+        std::vector<Entry> m_records;
+        std::unordered_map<uint32_t, Target> m_targets;
+    };
+}
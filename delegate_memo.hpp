@@ -0,0 +1,409 @@
+/*
+    带结果缓存的委托，用于包装耗时的纯函数
+    用法示例:
+        MemoDelegate<double, int, double> price({ pricer, &Pricer::Price }, 4096);  //最多缓存 4096 个结果
+        double a = price(7, 1.5);           //未命中，调用 Pricer::Price 并缓存结果
+        double b = price(7, 1.5);           //命中，直接返回缓存的结果
+        price.Invalidate(7, 1.5);           //删除一个结果
+        price.Clear();                      //删除所有结果（例如价格表更新之后）
+        printf("%zu/%zu", price.GetHits(), price.GetMisses());
+
+        ShardedMemoDelegate<Size, const Text&> measure({ layout, &Layout::Measure }, 65536);  //多个线程同时调用
+
+    其他:
+        1、参数按值（去掉 const 和引用）保存为键，每个参数类型都需要能用 std::hash 计算哈希值并能用 ==
+           比较，返回值需要可以复制。被包装的函数必须是纯函数：相同的参数总是得到相同的结果。
+        2、缓存是开放寻址（线性探测）的哈希表，表的大小为容量的两倍以上。缓存满时按 CLOCK 算法淘汰：
+           命中的结果会被标记，淘汰时跳过并清除被标记的结果，淘汰第一个未被标记的结果，近似于 LRU，
+           但命中时只写一个标记位，不需要移动链表节点。容量为 0 时不缓存。
+        3、调用过程中被包装的函数可以递归调用同一个 MemoDelegate（例如递归的动态规划）。
+        4、MemoDelegate 不是线程安全的。ShardedMemoDelegate 按哈希值把键分配到多个分片中，每个分片
+           有自己的锁和缓存，总容量平均分配给各个分片；查找和插入时只锁定一个分片，函数在锁外调用，
+           多个线程同时未命中同一个键时可能会重复计算。
+        5、GetHits 和 GetMisses 返回命中和未命中的次数，可以据此调整容量。Bind 重新绑定函数时会清空缓存。
+*/
+#pragma once
+#include<mutex>
+#include<tuple>
+#include<memory>
+#include<thread>
+#include<vector>
+#include<optional>
+#include<functional>
+#include"delegate.hpp"
+#if MYCODES_DELEGATE_LANG < 201703L
+#error(delegate_memo.hpp：请使用c++17及以上的版本)
+#endif
+
+namespace MyCodes
+{
+    //计算参数的哈希值，高位用于选择分片，低位用于在哈希表中定位
+    template<class...Ty_params>
+    inline uint64_t memoHash(const Ty_params&... params)
+    {
+        uint64_t hash = 0;
+        ((hash ^= std::hash<std::decay_t<Ty_params>>()(params) + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2)), ...);
+        hash ^= hash >> 30;
+        hash *= 0xBF58476D1CE4E5B9ull;
+        hash ^= hash >> 27;
+        hash *= 0x94D049BB133111EBull;
+        hash ^= hash >> 31;
+        return hash;
+    }
+
+    template<class Key, class Value>
+    class memo_cache //开放寻址、CLOCK 淘汰的结果缓存
+    {
+    public:
+        memo_cache(size_t capacity = 0)
+        {
+            Reset(capacity);
+        }
+
+        //查找并标记为最近使用，找不到时返回 nullptr
+        const Value* Find(uint64_t hash, const Key& key)noexcept
+        {
+            if (m_count == 0)
+                return nullptr;
+            for (size_t i = hash & m_mask; m_slots[i].entry; i = (i + 1) & m_mask)
+            {
+                Slot& slot = m_slots[i];
+                if (slot.hash == hash && slot.entry->first == key)
+                {
+                    slot.referenced = true;
+                    return &slot.entry->second;
+                }
+            }
+            return nullptr;
+        }
+        void Insert(uint64_t hash, const Key& key, const Value& value)
+        {
+            if (m_capacity == 0)
+                return;
+            size_t i = hash & m_mask;
+            for (; m_slots[i].entry; i = (i + 1) & m_mask)
+            {
+                if (m_slots[i].hash == hash && m_slots[i].entry->first == key)
+                {
+                    m_slots[i].entry->second = value;
+                    return;
+                }
+            }
+            if (m_count == m_capacity)
+            {
+                //淘汰会移动其他的结果，需要重新查找空位
+                evict();
+                for (i = hash & m_mask; m_slots[i].entry; i = (i + 1) & m_mask)
+                {
+                }
+            }
+            m_slots[i].entry.emplace(key, value);
+            m_slots[i].hash = hash;
+            m_slots[i].referenced = false;
+            m_count++;
+        }
+        bool Erase(uint64_t hash, const Key& key)noexcept
+        {
+            if (m_count == 0)
+                return false;
+            for (size_t i = hash & m_mask; m_slots[i].entry; i = (i + 1) & m_mask)
+            {
+                if (m_slots[i].hash == hash && m_slots[i].entry->first == key)
+                {
+                    eraseSlot(i);
+                    return true;
+                }
+            }
+            return false;
+        }
+        void Clear()noexcept
+        {
+            for (Slot& slot : m_slots)
+                slot.entry.reset();
+            m_count = 0;
+            m_hand = 0;
+        }
+        //修改容量，会清空缓存
+        void Reset(size_t capacity)
+        {
+            size_t tableSize = 2;
+            while (tableSize < capacity * 2)
+                tableSize *= 2;
+            m_slots.clear();
+            m_slots.resize(tableSize);
+            m_mask = tableSize - 1;
+            m_capacity = capacity;
+            m_count = 0;
+            m_hand = 0;
+        }
+
+        size_t size()const noexcept
+        {
+            return m_count;
+        }
+        size_t capacity()const noexcept
+        {
+            return m_capacity;
+        }
+
+    protected:
+        struct Slot
+        {
+            std::optional<std::pair<Key, Value>> entry;
+            uint64_t hash = 0;
+            bool referenced = false;
+        };
+
+        //CLOCK：跳过并清除被标记的结果，淘汰第一个未被标记的结果
+        void evict()noexcept
+        {
+            for (;; m_hand = (m_hand + 1) & m_mask)
+            {
+                Slot& slot = m_slots[m_hand];
+                if (!slot.entry)
+                    continue;
+                if (slot.referenced)
+                    slot.referenced = false;
+                else
+                {
+                    //后面的结果可能被移到当前位置，指针不前进，下次从这里继续
+                    eraseSlot(m_hand);
+                    return;
+                }
+            }
+        }
+        //删除后把后面同一个探测序列中的结果向前移动，不使用墓碑
+        void eraseSlot(size_t index)noexcept
+        {
+            for (size_t next = (index + 1) & m_mask; m_slots[next].entry; next = (next + 1) & m_mask)
+            {
+                const size_t home = m_slots[next].hash & m_mask;
+                //home 不在 (index, next] 之间时，该结果可以移动到 index
+                const bool stay = index <= next ? (index < home && home <= next) : (index < home || home <= next);
+                if (!stay)
+                {
+                    m_slots[index] = std::move(m_slots[next]);
+                    index = next;
+                }
+            }
+            m_slots[index].entry.reset();
+            m_count--;
+        }
+
+        std::vector<Slot> m_slots;
+        size_t m_mask = 0;
+        size_t m_capacity = 0;
+        size_t m_count = 0;
+        size_t m_hand = 0;      //CLOCK 指针
+    };
+
+    template<class Ty_ret, class...Ty_params>
+    class MemoDelegate //带结果缓存的委托
+    {
+        static_assert(!std::is_void_v<Ty_ret> && !std::is_reference_v<Ty_ret>, "MemoDelegate：返回值不能是 void 或引用");
+    public:
+        using DelegateSingle_Type = DelegateSingle<Ty_ret, Ty_params...>;
+        using Key = std::tuple<std::decay_t<Ty_params>...>;
+        using Value = std::remove_const_t<Ty_ret>;
+
+        MemoDelegate(const DelegateSingle_Type& fun = DelegateSingle_Type(), size_t capacity = 1024)
+            :m_fun(fun), m_cache(capacity)
+        {
+        }
+
+        //重新绑定函数，并清空缓存
+        void Bind(const DelegateSingle_Type& fun)
+        {
+            m_fun = fun;
+            m_cache.Clear();
+        }
+        const DelegateSingle_Type& GetDelegate()const noexcept
+        {
+            return m_fun;
+        }
+
+        Value Invoke(const Ty_params&... params)
+        {
+            const uint64_t hash = memoHash(params...);
+            const Key key(params...);
+            if (const Value* value = m_cache.Find(hash, key))
+            {
+                m_hits++;
+                return *value;
+            }
+            m_misses++;
+            //调用过程中可能递归地修改缓存，调用结束后再插入
+            Value value = m_fun(params...);
+            m_cache.Insert(hash, key, value);
+            return value;
+        }
+        Value operator()(const Ty_params&... params)
+        {
+            return Invoke(params...);
+        }
+
+        //删除一个结果，不存在时返回 false
+        bool Invalidate(const Ty_params&... params)
+        {
+            return m_cache.Erase(memoHash(params...), Key(params...));
+        }
+        void Clear()noexcept
+        {
+            m_cache.Clear();
+        }
+        //修改容量，会清空缓存
+        void SetCapacity(size_t capacity)
+        {
+            m_cache.Reset(capacity);
+        }
+        size_t GetCapacity()const noexcept
+        {
+            return m_cache.capacity();
+        }
+        size_t getsize()const noexcept
+        {
+            return m_cache.size();
+        }
+
+        size_t GetHits()const noexcept
+        {
+            return m_hits;
+        }
+        size_t GetMisses()const noexcept
+        {
+            return m_misses;
+        }
+        void ResetCounters()noexcept
+        {
+            m_hits = 0;
+            m_misses = 0;
+        }
+
+    protected:
+        DelegateSingle_Type m_fun;
+        memo_cache<Key, Value> m_cache;
+        size_t m_hits = 0;
+        size_t m_misses = 0;
+    };
+
+    template<class Ty_ret, class...Ty_params>
+    class ShardedMemoDelegate //分片的线程安全缓存委托
+    {
+        static_assert(!std::is_void_v<Ty_ret> && !std::is_reference_v<Ty_ret>, "ShardedMemoDelegate：返回值不能是 void 或引用");
+    public:
+        using DelegateSingle_Type = DelegateSingle<Ty_ret, Ty_params...>;
+        using Key = std::tuple<std::decay_t<Ty_params>...>;
+        using Value = std::remove_const_t<Ty_ret>;
+
+        //shards 为 0 时使用硬件线程数
+        ShardedMemoDelegate(const DelegateSingle_Type& fun, size_t capacity = 1024, size_t shards = 0)
+            :m_fun(fun)
+        {
+            if (shards == 0)
+                shards = std::thread::hardware_concurrency();
+            if (shards == 0)
+                shards = 1;
+            m_shardCount = shards;
+            m_shards.reset(new Shard[shards]);
+            for (size_t i = 0; i < shards; i++)
+                m_shards[i].cache.Reset((capacity + shards - 1) / shards);
+        }
+        ShardedMemoDelegate(const ShardedMemoDelegate&) = delete;
+        ShardedMemoDelegate& operator=(const ShardedMemoDelegate&) = delete;
+
+        Value Invoke(const Ty_params&... params)const
+        {
+            const uint64_t hash = memoHash(params...);
+            const Key key(params...);
+            Shard& shard = shardOf(hash);
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                if (const Value* value = shard.cache.Find(hash, key))
+                {
+                    shard.hits++;
+                    return *value;
+                }
+                shard.misses++;
+            }
+            Value value = m_fun(params...);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.cache.Insert(hash, key, value);
+            return value;
+        }
+        Value operator()(const Ty_params&... params)const
+        {
+            return Invoke(params...);
+        }
+
+        bool Invalidate(const Ty_params&... params)
+        {
+            const uint64_t hash = memoHash(params...);
+            Shard& shard = shardOf(hash);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            return shard.cache.Erase(hash, Key(params...));
+        }
+        void Clear()
+        {
+            for (size_t i = 0; i < m_shardCount; i++)
+            {
+                std::lock_guard<std::mutex> lock(m_shards[i].mutex);
+                m_shards[i].cache.Clear();
+            }
+        }
+        size_t getsize()const
+        {
+            return sum([](const Shard& shard) { return shard.cache.size(); });
+        }
+        size_t GetHits()const
+        {
+            return sum([](const Shard& shard) { return shard.hits; });
+        }
+        size_t GetMisses()const
+        {
+            return sum([](const Shard& shard) { return shard.misses; });
+        }
+        void ResetCounters()
+        {
+            for (size_t i = 0; i < m_shardCount; i++)
+            {
+                std::lock_guard<std::mutex> lock(m_shards[i].mutex);
+                m_shards[i].hits = 0;
+                m_shards[i].misses = 0;
+            }
+        }
+        size_t ShardCount()const noexcept
+        {
+            return m_shardCount;
+        }
+
+    protected:
+        struct alignas(64) Shard
+        {
+            std::mutex mutex;
+            memo_cache<Key, Value> cache;
+            size_t hits = 0;
+            size_t misses = 0;
+        };
+
+        Shard& shardOf(uint64_t hash)const noexcept
+        {
+            //低位用于在分片内定位，这里使用高位
+            return m_shards[static_cast<size_t>(hash >> 32) % m_shardCount];
+        }
+        template<class Fun>
+        size_t sum(Fun fun)const
+        {
+            size_t total = 0;
+            for (size_t i = 0; i < m_shardCount; i++)
+            {
+                std::lock_guard<std::mutex> lock(m_shards[i].mutex);
+                total += fun(m_shards[i]);
+            }
+            return total;
+        }
+
+        DelegateSingle_Type m_fun;
+        std::unique_ptr<Shard[]> m_shards;
+        size_t m_shardCount;
+    };
+}
@@ -0,0 +1,142 @@
+/*
+    委托流水线，每一级的输出作为下一级的输入
+    用法示例:
+        //编译期确定所有级：整个流水线是一个函数，中间值直接移动给下一级
+        using Parse = StaticPipeline<&tokenize, &parse, &validate, &optimize, &emit>;
+        Code code = Parse::Invoke(source);
+        DelegateSingle<Code, const std::string&> del = Parse::ToDelegate<Code, const std::string&>();
+
+        //运行时组装：每一级都是 DelegateSingle<T, const T&>，存放在连续的数组中
+        Pipeline<Image> filters;
+        filters.Then(&grayscale).Then(blur, &Blur::Apply).Then(sharpen);
+        Image out = filters(in);
+
+        //两个委托直接连接
+        DelegateSingle<int, const std::string&> len = &length;
+        DelegateSingle<bool, const int&> even = &isEven;
+        DelegateSingle<bool, const std::string&> lenIsEven = len.Then(even);
+
+    其他:
+        1、StaticPipeline 的每一级是编译期的函数指针（或类静态函数），上一级的返回值直接作为下一级
+           的参数，整条流水线在调用处内联为一个函数，不需要按 CallType 分派，也不复制中间值。
+           ToDelegate 把整条流水线绑定为一个静态委托，调用时只有一次间接调用。
+        2、Pipeline<T> 的每一级都接受 const T& 并返回新的 T，返回值移动赋值给当前值后传给下一级。
+           所有级存放在同一个连续数组中，调用时是一个紧凑的循环；空流水线原样返回输入。某一级中
+           调用 Clear 或 Then 修改流水线时，从下一级开始按修改后的流水线执行。
+        3、DelegateSingle::Then 只保存两个委托的地址（见 delegate.hpp 说明 10），适合连接两个
+           生命周期足够长的委托；Pipeline 中的每一级按值保存。
+        4、Pipeline 与 Delegate 一样不是线程安全的，捕获了变量的 lambda 只保存引用。
+*/
+#pragma once
+#include<utility>
+#include<functional>
+#include<type_traits>
+#include"delegate.hpp"
+#if MYCODES_DELEGATE_LANG < 201703L
+#error(delegate_pipeline.hpp：请使用c++17及以上的版本)
+#endif
+
+namespace MyCodes
+{
+    template<auto First, auto...Rest>
+    class StaticPipeline //编译期确定的流水线
+    {
+    public:
+        //依次调用每一级，返回最后一级的返回值
+        template<class...Args>
+        static decltype(auto) Invoke(Args&&... args)
+        {
+            if constexpr (sizeof...(Rest) == 0)
+                return std::invoke(First, std::forward<Args>(args)...);
+            else
+                return run<Rest...>(std::invoke(First, std::forward<Args>(args)...));
+        }
+
+        //与 Ty_ret(Ty_params...) 签名相同的静态函数
+        template<class Ty_ret, class...Ty_params>
+        static Ty_ret Call(Ty_params... params)
+        {
+            return static_cast<Ty_ret>(Invoke(std::forward<Ty_params>(params)...));
+        }
+        //把整条流水线绑定为一个静态委托
+        template<class Ty_ret, class...Ty_params>
+        static DelegateSingle<Ty_ret, Ty_params...> ToDelegate()noexcept
+        {
+            DelegateSingle<Ty_ret, Ty_params...> del;
+            del.Bind(&Call<Ty_ret, Ty_params...>);
+            return del;
+        }
+
+    protected:
+        template<auto Stage, auto...Others, class Ty_value>
+        static decltype(auto) run(Ty_value&& value)
+        {
+            //上一级的返回值是临时对象，直接移动给下一级
+            if constexpr (sizeof...(Others) == 0)
+                return std::invoke(Stage, std::forward<Ty_value>(value));
+            else
+                return run<Others...>(std::invoke(Stage, std::forward<Ty_value>(value)));
+        }
+    };
+
+    template<class Ty>
+    class Pipeline //运行时组装的流水线
+    {
+    public:
+        using Stage_Type = DelegateSingle<Ty, const Ty&>;
+
+        Pipeline() = default;
+
+        //在末尾添加一级，空委托会被跳过
+        Pipeline& Then(const Stage_Type& stage)
+        {
+            if (!stage.IsNull())
+                m_stages.push_back(stage);
+            return *this;
+        }
+        template<class...Args>
+        Pipeline& Then(const Args&... args)
+        {
+            Stage_Type temp;
+            temp.Bind(args...);
+            return Then(temp);
+        }
+        Pipeline& operator+=(const Stage_Type& stage)
+        {
+            return Then(stage);
+        }
+
+        void Clear()noexcept
+        {
+            m_stages.clear();
+        }
+        bool Empty()const noexcept
+        {
+            return m_stages.empty();
+        }
+        size_t getsize()const noexcept
+        {
+            return m_stages.size();
+        }
+        const delegate_array<Stage_Type>& GetArray()const noexcept
+        {
+            return m_stages;
+        }
+
+        //依次调用每一级
+        Ty Invoke(Ty value)const
+        {
+            //与 Delegate::Invoke 一样每次都重新读取数量，某一级中 Clear 或添加级时不会越界访问
+            for (size_t i = 0; i < m_stages.size(); i++)
+                value = m_stages[i].InvokeUnchecked(value);
+            return value;
+        }
+        Ty operator()(Ty value)const
+        {
+            return Invoke(std::move(value));
+        }
+
+    protected:
+        delegate_array<Stage_Type> m_stages;
+    };
+}
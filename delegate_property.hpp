@@ -0,0 +1,296 @@
+/*
+    可观察的属性，值真正改变时才通知，并支持批量修改
+    用法示例:
+        Property<int> hp = 100;
+        hp.OnChanged += onHpChanged;        //void onHpChanged(const int& oldValue, const int& newValue)
+        hp = 100;                           //值没有改变，不通知
+        hp = 80;                            //通知一次 (100, 80)
+        {
+            Transaction tr;                 //作用域内的修改延迟到作用域结束时通知
+            hp = 70;
+            hp = 60;
+            mp = 20;
+        }                                   //hp 通知一次 (80, 60)，mp 通知一次
+
+        PropertyView<int> view = hp;        //只能读取和订阅，不能修改
+
+    其他:
+        1、Property<T> 内部使用 Delegate<void, const T&, const T&> 存储订阅者，参数分别为
+           旧值和新值。T 需要可以用 == 比较。
+        2、Transaction 作用于当前线程，可以嵌套，只有最外层的 Transaction 结束时才统一通知。
+           每个被修改过的属性只通知一次，旧值为事务开始前的值；如果最终的值与事务开始前相同，
+           则不通知。通知按属性第一次被修改的顺序进行，通知时事务已经结束，回调中对属性的修改
+           会立即通知。
+        3、Transaction::Rollback 把事务中修改过的属性恢复为事务开始前的值，不通知。也可以在
+           最外层事务结束前调用 Commit 提前通知。
+        4、事务中修改过的属性在事务结束前析构时会自动从事务中移除。属性本身不是线程安全的。
+        5、最外层的 Transaction 因为异常离开作用域时（栈展开中析构），会自动 Rollback 而不是通知。
+           析构函数是 noexcept 的，析构时提交过程中抛出的异常（例如值的比较或移动）会被忽略；需要
+           处理这些异常时，应在作用域结束前显式调用 Commit。提交过程中抛出异常时，剩下的属性保留
+           新的值但不再通知。
+*/
+#pragma once
+#include<vector>
+#include<optional>
+#include<exception>
+#include<algorithm>
+#include"delegate.hpp"
+#if MYCODES_DELEGATE_LANG < 201703L
+#error(delegate_property.hpp：请使用c++17及以上的版本)
+#endif
+
+namespace MyCodes
+{
+    class Transaction;
+
+    class Property_base
+    {
+        friend class Transaction;
+    protected:
+        Property_base() = default;
+        inline ~Property_base();
+
+        //事务结束时调用，通知事务中的修改
+        virtual void commit() = 0;
+        //恢复为事务开始前的值
+        virtual void rollback() = 0;
+
+        Transaction* m_transaction = nullptr;   //记录了修改的事务
+    };
+
+    class Transaction //批量修改属性，作用域结束时统一通知
+    {
+        friend class Property_base;
+        template<class>
+        friend class Property;
+    public:
+        Transaction()noexcept
+        {
+            m_outer = current();
+            m_uncaught = std::uncaught_exceptions();
+            current() = this;
+        }
+        Transaction(const Transaction&) = delete;
+        Transaction& operator=(const Transaction&) = delete;
+        ~Transaction()
+        {
+            if (m_outer == nullptr)
+            {
+                //析构函数不能抛出异常，提交或恢复旧值时的异常在这里被忽略
+                try
+                {
+                    if (std::uncaught_exceptions() > m_uncaught)
+                        Rollback();
+                    else
+                        Commit();
+                }
+                catch (...)
+                {
+                }
+            }
+            current() = m_outer;
+        }
+
+        //立即通知所有已修改的属性，只有最外层的事务可以提交
+        void Commit()
+        {
+            if (m_outer != nullptr)
+                return;
+            //通知时事务已经不在生效，回调中的修改会立即通知
+            std::vector<Property_base*> pending;
+            pending.swap(m_pending);
+            Commit_guard guard{ *this, pending, current() };
+            current() = nullptr;
+            //回调中可能会析构后面的属性，此时 pending 中对应的位置为 nullptr
+            m_committing = &pending;
+            while (guard.next < pending.size())
+            {
+                Property_base* prop = pending[guard.next++];
+                if (prop != nullptr)
+                {
+                    prop->m_transaction = nullptr;
+                    prop->commit();
+                }
+            }
+        }
+        //放弃所有修改，不通知
+        void Rollback()
+        {
+            Transaction* outermost = this;
+            while (outermost->m_outer != nullptr)
+                outermost = outermost->m_outer;
+            for (Property_base* prop : outermost->m_pending)
+            {
+                if (prop != nullptr)
+                {
+                    prop->m_transaction = nullptr;
+                    prop->rollback();
+                }
+            }
+            outermost->m_pending.clear();
+        }
+
+        //当前线程中最外层的事务，没有事务时返回 nullptr
+        static Transaction* Current()noexcept
+        {
+            Transaction* tr = current();
+            while (tr != nullptr && tr->m_outer != nullptr)
+                tr = tr->m_outer;
+            return tr;
+        }
+
+    protected:
+        //提交结束（或回调抛出异常）后恢复事务的状态
+        struct Commit_guard
+        {
+            ~Commit_guard()
+            {
+                //抛出异常时剩下的属性不再通知，也不再记录这个事务
+                for (; next < pending.size(); next++)
+                {
+                    if (pending[next] != nullptr)
+                        pending[next]->m_transaction = nullptr;
+                }
+                tr.m_committing = nullptr;
+                current() = self;
+            }
+            Transaction& tr;
+            std::vector<Property_base*>& pending;
+            Transaction* self;
+            size_t next = 0;
+        };
+
+        static Transaction*& current()noexcept
+        {
+            thread_local Transaction* _current = nullptr;
+            return _current;
+        }
+
+        void add(Property_base& prop)
+        {
+            prop.m_transaction = this;
+            m_pending.push_back(&prop);
+        }
+        void remove(Property_base& prop)noexcept
+        {
+            std::replace(m_pending.begin(), m_pending.end(), &prop, static_cast<Property_base*>(nullptr));
+            if (m_committing != nullptr)
+                std::replace(m_committing->begin(), m_committing->end(), &prop, static_cast<Property_base*>(nullptr));
+        }
+
+        Transaction* m_outer;
+        int m_uncaught;                         //构造时正在传播的异常数量
+        std::vector<Property_base*> m_pending;
+        std::vector<Property_base*>* m_committing = nullptr;
+    };
+
+    inline Property_base::~Property_base()
+    {
+        if (m_transaction != nullptr)
+            m_transaction->remove(*this);
+    }
+
+    template<class Ty>
+    class Property :public Property_base //可观察的属性
+    {
+    public:
+        using DelegateType = Delegate<void, const Ty&, const Ty&>;
+        using ViewType = Delegate_view<void, const Ty&, const Ty&>;
+
+        ViewType OnChanged = m_changed;
+
+        Property(const Ty& value = Ty())
+            :m_value(value)
+        {
+        }
+        Property(const Property&) = delete;
+        Property& operator=(const Property&) = delete;
+
+        const Ty& Get()const noexcept
+        {
+            return m_value;
+        }
+        operator const Ty& ()const noexcept
+        {
+            return m_value;
+        }
+
+        //设置新值，值改变时返回 true。在事务中只记录旧值，事务结束时再通知
+        bool Set(const Ty& value)
+        {
+            if (m_value == value)
+                return false;
+
+            if (Transaction* tr = Transaction::Current())
+            {
+                if (m_transaction == nullptr)
+                {
+                    m_original.emplace(m_value);
+                    tr->add(*this);
+                }
+                m_value = value;
+                return true;
+            }
+
+            Ty old = m_value;
+            m_value = value;
+            m_changed(old, m_value);
+            return true;
+        }
+        Property& operator=(const Ty& value)
+        {
+            Set(value);
+            return *this;
+        }
+
+        //内部的多播委托，可以直接调用或遍历
+        const DelegateType& GetDelegate()const noexcept
+        {
+            return m_changed;
+        }
+
+    protected:
+        void commit()override
+        {
+            Ty old = std::move(*m_original);
+            m_original.reset();
+            if (!(old == m_value))
+                m_changed(old, m_value);
+        }
+        void rollback()override
+        {
+            m_value = std::move(*m_original);
+            m_original.reset();
+        }
+
+        Ty m_value;
+        std::optional<Ty> m_original;   //事务开始前的值
+        DelegateType m_changed;
+    };
+
+    template<class Ty>
+    class PropertyView //属性视图，只能读取和订阅
+    {
+    public:
+        using ViewType = Delegate_view<void, const Ty&, const Ty&>;
+
+        ViewType OnChanged;
+
+        PropertyView(Property<Ty>& prop)noexcept
+            :OnChanged(prop.OnChanged), m_prop(&prop)
+        {
+        }
+
+        const Ty& Get()const noexcept
+        {
+            return m_prop->Get();
+        }
+        operator const Ty& ()const noexcept
+        {
+            return m_prop->Get();
+        }
+
+    protected:
+        const Property<Ty>* m_prop;
+    };
+}
@@ -0,0 +1,376 @@
+/*
+    跨线程排队委托
+    用法示例:
+        EventLoop uiLoop;                               //在 ui 线程中构造（或调用 BindThread）
+        Delegate<void,int> del;
+        del.Add(DelegateSingle<void,int>(view, &View::Update), uiLoop);
+        del(1);                                         //任意线程调用，只是把调用投递到 uiLoop
+        uiLoop.Drain();                                 //ui 线程中批量执行投递过来的调用
+
+    其他:
+        1、EventLoop 内部是一个有界的多生产者单消费者无锁环形队列，每个槽位中直接
+           存放目标委托和复制的参数，投递时不会分配内存。参数会按值复制，因此参数
+           类型需要可以复制构造，并且目标委托和参数的总大小不能超过 MYCODES_DELEGATE_MAILBOX_PAYLOAD
+           （默认 96 字节）。
+        2、QueueMode::post 为投递后立即返回；QueueMode::send 会阻塞调用线程，直到目标
+           线程执行完毕。在 EventLoop 所在的线程中 send 时会直接调用，不会死锁。
+        3、队列满时，投递线程会让出时间片等待，直到 EventLoop 所在的线程取出消息。
+           若在 EventLoop 所在的线程中投递时队列已满，会先执行队列中已有的消息。
+        4、排队委托只支持返回 void 的委托。移除时需要使用 Sub(del, loop) 。
+        5、EventLoop 的生命周期需要长于添加了排队委托的多播委托。
+        6、消息抛出异常时，该消息仍会被析构并移出队列，异常从 Drain 传出，剩下的消息留到下一次
+           Drain 执行。send 模式下异常会被传回调用 Send 的线程重新抛出，调用线程不会一直等待。
+        7、WaitAndDrain 和 Send 的等待都会阻塞线程而不是忙等：c++20 及以上 WaitAndDrain 使用
+           std::atomic::wait，c++17 使用互斥锁和条件变量；Send 总是使用互斥锁和条件变量。
+           投递时只有 WaitAndDrain 正在等待才会唤醒，没有等待方时投递不会进入系统调用。
+*/
+#pragma once
+#include<mutex>
+#include<tuple>
+#include<atomic>
+#include<memory>
+#include<thread>
+#include<vector>
+#include<cstdint>
+#include<exception>
+#include<cstddef>
+#include<condition_variable>
+#include"delegate.hpp"
+#if MYCODES_DELEGATE_LANG < 201703L
+#error(delegate_queued.hpp：请使用c++17及以上的版本)
+#endif
+#ifndef MYCODES_DELEGATE_MAILBOX_PAYLOAD
+#define MYCODES_DELEGATE_MAILBOX_PAYLOAD 96
+#endif
+
+namespace MyCodes
+{
+    enum class QueueMode //排队委托的调用方式
+    {
+        post,   //投递后立即返回
+        send    //等待目标线程执行完毕
+    };
+
+    class EventLoop //带有无锁邮箱的事件循环
+    {
+    public:
+        static constexpr size_t payload_size = MYCODES_DELEGATE_MAILBOX_PAYLOAD;
+
+        //capacity 会向上取整为 2 的幂
+        EventLoop(size_t capacity = 1024)
+        {
+            size_t size = 2;
+            while (size < capacity)
+                size <<= 1;
+            m_mask = size - 1;
+            m_slots.reset(new Slot[size]);
+            for (size_t i = 0; i < size; i++)
+                m_slots[i].seq.store(i, std::memory_order_relaxed);
+            m_owner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+        }
+        EventLoop(const EventLoop&) = delete;
+        EventLoop& operator=(const EventLoop&) = delete;
+        ~EventLoop()
+        {
+            while (Drain() != 0)
+            {
+            }
+        }
+
+        //把当前线程设置为执行消息的线程
+        void BindThread()noexcept
+        {
+            m_owner.store(std::this_thread::get_id(), std::memory_order_release);
+        }
+        bool InThread()const noexcept
+        {
+            return std::this_thread::get_id() == m_owner.load(std::memory_order_acquire);
+        }
+
+        //投递一个可调用对象，队列满时返回 false
+        template<class Fun>
+        bool TryPost(Fun&& fun)
+        {
+            using Message = std::decay_t<Fun>;
+            static_assert(sizeof(Message) <= payload_size, "EventLoop：消息超过了 MYCODES_DELEGATE_MAILBOX_PAYLOAD");
+            static_assert(alignof(Message) <= alignof(std::max_align_t), "EventLoop：消息的对齐要求过高");
+
+            size_t pos = m_enqueue.load(std::memory_order_relaxed);
+            Slot* slot;
+            for (;;)
+            {
+                slot = &m_slots[pos & m_mask];
+                const size_t seq = slot->seq.load(std::memory_order_acquire);
+                const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                if (diff == 0)
+                {
+                    if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = m_enqueue.load(std::memory_order_relaxed);
+                }
+            }
+
+            new(slot->payload) Message(std::forward<Fun>(fun));
+            slot->run = &runMessage<Message>;
+            slot->seq.store(pos + 1, std::memory_order_release);
+            //只有 WaitAndDrain 正在等待时才唤醒，与 WaitAndDrain 中的 m_waiting、m_signal 构成
+            //Dekker 式的顺序一致读写：要么这里看到 m_waiting，要么等待方看到新的 m_signal
+            m_signal.fetch_add(1, std::memory_order_seq_cst);
+            if (m_waiting.load(std::memory_order_seq_cst))
+                notifySignal();
+            return true;
+        }
+        //投递一个可调用对象，队列满时等待
+        template<class Fun>
+        void Post(Fun&& fun)
+        {
+            while (!TryPost(fun))
+            {
+                if (InThread())
+                    Drain();
+                else
+                    std::this_thread::yield();
+            }
+        }
+        //投递并等待执行完毕，在所在线程中调用时直接执行
+        template<class Fun>
+        void Send(Fun&& fun)
+        {
+            if (InThread())
+            {
+                fun();
+                return;
+            }
+
+            //在互斥锁下设置完成标志并唤醒，Send 返回（销毁这些局部变量）之前消息不会再访问它们
+            std::mutex mutex;
+            std::condition_variable cond;
+            bool done = false;
+            std::exception_ptr error;
+            Post([&fun, &mutex, &cond, &done, &error]()
+                {
+                    try
+                    {
+                        fun();
+                    }
+                    catch (...)
+                    {
+                        error = std::current_exception();
+                    }
+                    std::lock_guard<std::mutex> lock(mutex);
+                    done = true;
+                    cond.notify_one();
+                });
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cond.wait(lock, [&done] { return done; });
+            }
+            if (error)
+                std::rethrow_exception(error);
+        }
+
+        //执行最多 maxBatch 个消息，返回执行的数量。只能在所在线程中调用
+        size_t Drain(size_t maxBatch = SIZE_MAX)
+        {
+            size_t count = 0;
+            while (count < maxBatch)
+            {
+                //消息中可能再次调用 Drain，所以先移动读取位置再执行
+                const size_t pos = m_dequeue;
+                Slot& slot = m_slots[pos & m_mask];
+                if (slot.seq.load(std::memory_order_acquire) != pos + 1)
+                    break;
+
+                m_dequeue = pos + 1;
+                count++;
+                Release_guard guard{ slot, pos + m_mask + 1 };
+                slot.run(slot.payload);
+            }
+            return count;
+        }
+        //没有消息时阻塞，直到有新的消息投递过来，然后执行
+        size_t WaitAndDrain(size_t maxBatch = SIZE_MAX)
+        {
+            const uint32_t signal = m_signal.load(std::memory_order_acquire);
+            size_t count = Drain(maxBatch);
+            if (count != 0)
+                return count;
+
+            waitSignal(signal);
+            return Drain(maxBatch);
+        }
+
+        //生成一个把调用投递到本循环的委托，供 Delegate_base::Add(del, loop) 使用
+        template<class DelType>
+        DelType Queue(const DelType& del, QueueMode mode = QueueMode::post)
+        {
+            std::lock_guard<std::mutex> lock(m_connMutex);
+            for (auto& conn : m_connections)
+            {
+                auto* _conn = dynamic_cast<Connection<DelType>*>(conn.get());
+                if (_conn && _conn->target == del && _conn->mode == mode)
+                {
+                    _conn->refs++;
+                    return _conn->stub;
+                }
+            }
+
+            auto* conn = new Connection<DelType>(*this, del, mode);
+            m_connections.emplace_back(conn);
+            return conn->stub;
+        }
+        //释放 Queue 生成的委托，返回该委托，没有找到时返回空委托
+        template<class DelType>
+        DelType Unqueue(const DelType& del)
+        {
+            std::lock_guard<std::mutex> lock(m_connMutex);
+            for (auto it = m_connections.begin(); it != m_connections.end(); it++)
+            {
+                auto* conn = dynamic_cast<Connection<DelType>*>(it->get());
+                if (conn && conn->target == del)
+                {
+                    DelType stub = conn->stub;
+                    if (--conn->refs == 0)
+                        m_connections.erase(it);
+                    return stub;
+                }
+            }
+            return DelType();
+        }
+        //查找 Queue 生成的委托，不改变引用计数
+        template<class DelType>
+        DelType FindQueued(const DelType& del)const
+        {
+            std::lock_guard<std::mutex> lock(m_connMutex);
+            for (const auto& conn : m_connections)
+            {
+                auto* _conn = dynamic_cast<const Connection<DelType>*>(conn.get());
+                if (_conn && _conn->target == del)
+                    return _conn->stub;
+            }
+            return DelType();
+        }
+
+    protected:
+        struct Slot
+        {
+            std::atomic<size_t> seq;
+            void(*run)(void* payload);
+            alignas(std::max_align_t) unsigned char payload[payload_size];
+        };
+
+        //消息执行完毕（或抛出异常）后把槽位交还给生产者
+        struct Release_guard
+        {
+            ~Release_guard()
+            {
+                slot.seq.store(seq, std::memory_order_release);
+            }
+            Slot& slot;
+            size_t seq;
+        };
+        template<class Message>
+        struct Destroy_guard
+        {
+            ~Destroy_guard()
+            {
+                msg->~Message();
+            }
+            Message* msg;
+        };
+
+        //等待 m_signal 不再等于 signal，只在所在线程中调用
+        void waitSignal(uint32_t signal)
+        {
+        #if MYCODES_DELEGATE_LANG > 201703L
+            m_waiting.store(true, std::memory_order_seq_cst);
+            if (m_signal.load(std::memory_order_seq_cst) == signal)
+                m_signal.wait(signal, std::memory_order_acquire);
+        #else
+            std::unique_lock<std::mutex> lock(m_waitMutex);
+            m_waiting.store(true, std::memory_order_seq_cst);
+            m_waitCond.wait(lock, [this, signal] { return m_signal.load(std::memory_order_seq_cst) != signal; });
+        #endif
+            m_waiting.store(false, std::memory_order_relaxed);
+        }
+        void notifySignal()
+        {
+        #if MYCODES_DELEGATE_LANG > 201703L
+            m_signal.notify_one();
+        #else
+            //先取得互斥锁，等待方检查条件和进入等待之间不会错过唤醒
+            std::lock_guard<std::mutex> lock(m_waitMutex);
+            m_waitCond.notify_one();
+        #endif
+        }
+
+        template<class Message>
+        static void runMessage(void* payload)
+        {
+            Destroy_guard<Message> guard{ static_cast<Message*>(payload) };
+            (*guard.msg)();
+        }
+
+        struct Connection_base
+        {
+            virtual ~Connection_base() = default;
+            size_t refs = 1;
+        };
+
+        template<class DelType>
+        struct Connection;
+
+        template<template<class, class...>class _DelegateSingle, class Ty_ret, class...Ty_params>
+        struct Connection<_DelegateSingle<Ty_ret, Ty_params...>> :Connection_base
+        {
+            static_assert(std::is_void_v<Ty_ret>, "排队委托只支持返回 void 的委托");
+            using DelType = _DelegateSingle<Ty_ret, Ty_params...>;
+
+            Connection(EventLoop& _loop, const DelType& del, QueueMode _mode)
+                :loop(&_loop), target(del), mode(_mode)
+            {
+                stub.Bind(*this, &Connection::Call);
+            }
+
+            void Call(Ty_params... params)
+            {
+                //复制目标委托和参数，在目标线程中调用
+                auto msg = [del = target, args = std::tuple<std::decay_t<Ty_params>...>(params...)]()
+                {
+                    std::apply([&del](const auto&... _args) { del.Invoke(_args...); }, args);
+                };
+                if (mode == QueueMode::send)
+                    loop->Send(msg);
+                else
+                    loop->Post(std::move(msg));
+            }
+
+            EventLoop* loop;
+            DelType target;
+            DelType stub;
+            QueueMode mode;
+        };
+
+        std::unique_ptr<Slot[]> m_slots;
+        size_t m_mask;
+        alignas(64) std::atomic<size_t> m_enqueue{ 0 };
+        alignas(64) size_t m_dequeue = 0;
+        std::atomic<uint32_t> m_signal{ 0 };
+        std::atomic<bool> m_waiting{ false };   //WaitAndDrain 是否正在等待
+    #if MYCODES_DELEGATE_LANG <= 201703L
+        std::mutex m_waitMutex;
+        std::condition_variable m_waitCond;
+    #endif
+        std::atomic<std::thread::id> m_owner;
+
+        mutable std::mutex m_connMutex;
+        std::vector<std::unique_ptr<Connection_base>> m_connections;
+    };
+}
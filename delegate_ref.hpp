@@ -0,0 +1,128 @@
+/*
+    不拥有目标的委托引用，用作回调参数
+    用法示例:
+        void ForEachEnemy(DelegateRef<void(Enemy&)> visit)     //按值传递，两个指针大小
+        {
+            for (Enemy& e : m_enemies)
+                visit(e);
+        }
+        ForEachEnemy([&](Enemy& e) { total += e.hp; });         //任意可调用对象
+        ForEachEnemy(&damageEnemy);                             //函数指针
+        ForEachEnemy(del);                                      //已有的 DelegateSingle<void,Enemy&>
+        ForEachEnemy(DelegateRef<void(Enemy&)>::Make<&Player::Visit>(player));  //类成员函数
+
+    其他:
+        1、DelegateRef 只保存目标的地址和一个调用函数的指针，可以平凡复制，按值传递时放在
+           寄存器中；调用时只经过一次间接调用，不需要像 DelegateSingle 那样按 CallType 分派，
+           也不会像 std::function 那样分配内存。
+        2、DelegateRef 不拥有目标，只在目标的生命周期内有效，适合作为函数参数，在函数返回前
+           使用。不要用临时的 lambda 初始化 DelegateRef 类型的变量再在之后调用。
+        3、绑定 DelegateSingle 时引用的是委托对象本身，调用时按委托当前绑定的目标调用。
+        4、运行时的成员函数指针无法和对象一起放进两个指针中，因此类成员函数需要用 Make 在编译
+           期指定：Make<&Obj::Fun>(obj)。Make<&fun>() 绑定的普通函数在调用时没有额外的间接调用。
+        5、DelegateRef 不能为空，没有默认构造函数。
+*/
+#pragma once
+#include<utility>
+#include<functional>
+#include<type_traits>
+#include"delegate.hpp"
+#if MYCODES_DELEGATE_LANG < 201703L
+#error(delegate_ref.hpp：请使用c++17及以上的版本)
+#endif
+
+namespace MyCodes
+{
+    template<class Signature>
+    class DelegateRef;
+
+    template<class Ty_ret, class...Ty_params>
+    class DelegateRef<Ty_ret(Ty_params...)> //不拥有目标的委托引用
+    {
+    public:
+        //任意可调用对象（包括 lambda、仿函数和 DelegateSingle）
+        template<class Fun, std::enable_if_t<!std::is_same_v<std::decay_t<Fun>, DelegateRef> &&
+            !std::is_function_v<std::remove_pointer_t<std::decay_t<Fun>>> &&
+            std::is_invocable_r_v<Ty_ret, Fun&, Ty_params...>, int> = 0>
+        DelegateRef(Fun&& fun)noexcept
+        {
+            using Obj = std::remove_reference_t<Fun>;
+            m_target.obj = const_cast<void*>(static_cast<const volatile void*>(std::addressof(fun)));
+            m_thunk = [](Target target, Ty_params... params)->Ty_ret
+            {
+                return call(*static_cast<Obj*>(target.obj), std::forward<Ty_params>(params)...);
+            };
+        }
+        //函数指针
+        template<class Fun, std::enable_if_t<std::is_function_v<std::remove_pointer_t<std::decay_t<Fun>>> &&
+            std::is_invocable_r_v<Ty_ret, Fun&, Ty_params...>, int> = 0>
+        DelegateRef(Fun&& fun)noexcept
+        {
+            using FunPtr = std::decay_t<Fun>;
+            m_target.fun = reinterpret_cast<void(*)()>(static_cast<FunPtr>(fun));
+            m_thunk = [](Target target, Ty_params... params)->Ty_ret
+            {
+                return call(reinterpret_cast<FunPtr>(target.fun), std::forward<Ty_params>(params)...);
+            };
+        }
+        DelegateRef(const DelegateRef&) = default;
+        DelegateRef& operator=(const DelegateRef&) = default;
+
+        //编译期指定的普通函数
+        template<auto Fun>
+        static DelegateRef Make()noexcept
+        {
+            static_assert(std::is_invocable_r_v<Ty_ret, decltype(Fun), Ty_params...>, "DelegateRef::Make：函数与签名不匹配");
+            DelegateRef ref;
+            ref.m_target.obj = nullptr;
+            ref.m_thunk = [](Target, Ty_params... params)->Ty_ret
+            {
+                return call(Fun, std::forward<Ty_params>(params)...);
+            };
+            return ref;
+        }
+        //编译期指定的类成员函数，obj 为调用的对象
+        template<auto Fun, class Obj>
+        static DelegateRef Make(Obj& obj)noexcept
+        {
+            static_assert(std::is_invocable_r_v<Ty_ret, decltype(Fun), Obj&, Ty_params...>, "DelegateRef::Make：函数与签名不匹配");
+            DelegateRef ref;
+            ref.m_target.obj = const_cast<void*>(static_cast<const volatile void*>(std::addressof(obj)));
+            ref.m_thunk = [](Target target, Ty_params... params)->Ty_ret
+            {
+                return call(Fun, *static_cast<Obj*>(target.obj), std::forward<Ty_params>(params)...);
+            };
+            return ref;
+        }
+
+        Ty_ret Invoke(Ty_params... params)const
+        {
+            return m_thunk(m_target, std::forward<Ty_params>(params)...);
+        }
+        Ty_ret operator()(Ty_params... params)const
+        {
+            return m_thunk(m_target, std::forward<Ty_params>(params)...);
+        }
+
+    protected:
+        union Target
+        {
+            void* obj;
+            void(*fun)();
+        };
+
+        DelegateRef() = default;
+
+        template<class Fun, class...Args>
+        static Ty_ret call(Fun&& fun, Args&&... args)
+        {
+            if constexpr (std::is_void_v<Ty_ret>)
+                std::invoke(std::forward<Fun>(fun), std::forward<Args>(args)...);
+            else
+                return std::invoke(std::forward<Fun>(fun), std::forward<Args>(args)...);
+        }
+
+        Target m_target;
+        Ty_ret(*m_thunk)(Target, Ty_params...);
+    };
+}
@@ -0,0 +1,274 @@
+/*
+    分片的多播委托，用于大量线程同时注册和删除委托的场景
+    用法示例:
+        ShardedDelegate<void,int> onConnect;        //默认分片数为硬件线程数
+        onConnect.Add(handler, &Handler::OnConnect);//任意线程调用，只锁定当前线程对应的分片
+        onConnect(1);                               //调用所有分片中的委托
+
+    其他:
+        1、每个线程第一次使用时会被分配一个固定的分片，Add 只锁定这个分片，不同线程之间
+           的注册基本不会互相竞争。Sub 和 Have 先查找当前线程的分片，再查找其他分片。
+        2、Invoke 遍历的是合并后的快照。每个分片有自己的代数，分片发生变化时只增加这个
+           分片的代数，不同线程的 Add、Sub 不会争抢同一个缓存行。Invoke 逐个比较分片的代数
+           和快照合并时记录的代数，发现快照过期时才重新合并，注册稳定后 Invoke 只有每个
+           分片一次原子读取加一次数组遍历。调用过程中可以安全地 Add 或 Sub，变化会在下一次
+           Invoke 时生效。
+        3、快照通过危险指针（delegate_hazard.hpp）读取，没有引用计数的原子读改写。被替换的
+           快照在没有调用方使用后，由之后的合并或析构函数释放，析构时不能有正在进行的调用。
+        4、InvokeDirect 不使用快照，而是依次锁定每一个分片、复制其中的委托后解锁再调用，
+           委托中可以对任意分片 Add 或 Sub，变化只影响之后的分片和调用。
+        5、不同分片之间的调用顺序与注册顺序无关，返回值不为 void 时，返回合并后最后
+           一个委托的返回值。
+*/
+#pragma once
+#include<mutex>
+#include<atomic>
+#include<memory>
+#include<thread>
+#include<vector>
+#include"delegate_hazard.hpp"
+#if MYCODES_DELEGATE_LANG < 201703L
+#error(delegate_sharded.hpp：请使用c++17及以上的版本)
+#endif
+
+namespace MyCodes
+{
+    inline size_t currentShardIndex()noexcept
+    {
+        static std::atomic<size_t> next{ 0 };
+        thread_local const size_t index = next.fetch_add(1, std::memory_order_relaxed);
+        return index;
+    }
+
+    template<class Ty_ret, class...Ty_params>
+    class ShardedDelegate //分片的多播委托
+    {
+    public:
+        using DelegateSingle_Type = DelegateSingle<Ty_ret, Ty_params...>;
+        using Snapshot_guard = delegate_hazard::Guard<std::vector<DelegateSingle_Type>>;
+
+        ShardedDelegate(size_t shards = 0)
+        {
+            if (shards == 0)
+                shards = std::thread::hardware_concurrency();
+            if (shards == 0)
+                shards = 1;
+            m_shardCount = shards;
+            m_shards.reset(new Shard[shards]);
+            m_snapshot.store(new Merged(), std::memory_order_relaxed);
+        }
+        ShardedDelegate(const ShardedDelegate&) = delete;
+        ShardedDelegate& operator=(const ShardedDelegate&) = delete;
+        //析构时不能有正在进行的调用
+        ~ShardedDelegate()
+        {
+            delete m_snapshot.load(std::memory_order_relaxed);
+            for (const Merged* merged : m_retired)
+                delete merged;
+        }
+
+        //添加委托
+        void Add(const DelegateSingle_Type& del)
+        {
+            if (del.IsNull())
+                return;
+            Shard& shard = localShard();
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.dels.push_back(del);
+            shard.generation.fetch_add(1, std::memory_order_release);
+        }
+        template<class...Args>
+        void Add(const Args&... args)
+        {
+            DelegateSingle_Type temp;
+            temp.Bind(args...);
+            Add(temp);
+        }
+        ShardedDelegate& operator+=(const DelegateSingle_Type& del)
+        {
+            Add(del);
+            return *this;
+        }
+
+        //删除委托
+        bool Sub(const DelegateSingle_Type& del)
+        {
+            const size_t first = currentShardIndex() % m_shardCount;
+            for (size_t i = 0; i < m_shardCount; i++)
+            {
+                Shard& shard = m_shards[(first + i) % m_shardCount];
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                if (subDelegate(del, shard.dels))
+                {
+                    shard.generation.fetch_add(1, std::memory_order_release);
+                    return true;
+                }
+            }
+            return false;
+        }
+        template<class...Args>
+        bool Sub(const Args&... args)
+        {
+            DelegateSingle_Type temp;
+            temp.Bind(args...);
+            return Sub(temp);
+        }
+        bool operator-=(const DelegateSingle_Type& del)
+        {
+            return Sub(del);
+        }
+
+        bool Have(const DelegateSingle_Type& del)const
+        {
+            for (size_t i = 0; i < m_shardCount; i++)
+            {
+                const Shard& shard = m_shards[i];
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                if (haveDelegate(del, shard.dels))
+                    return true;
+            }
+            return false;
+        }
+        template<class...Args>
+        bool Have(const Args&... args)const
+        {
+            DelegateSingle_Type temp;
+            temp.Bind(args...);
+            return Have(temp);
+        }
+
+        void Clear()
+        {
+            for (size_t i = 0; i < m_shardCount; i++)
+            {
+                Shard& shard = m_shards[i];
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                shard.dels.clear();
+                shard.generation.fetch_add(1, std::memory_order_release);
+            }
+        }
+        bool Empty()const
+        {
+            return Snapshot()->empty();
+        }
+        size_t getsize()const
+        {
+            return Snapshot()->size();
+        }
+        size_t ShardCount()const noexcept
+        {
+            return m_shardCount;
+        }
+
+        //合并所有分片后的快照，快照过期时重新合并。返回的对象存在期间快照不会被释放
+        Snapshot_guard Snapshot()const
+        {
+            if (stale())
+                merge();
+            return Snapshot_guard(m_snapshot);
+        }
+
+        //触发调用
+        Ty_ret Invoke(const Ty_params&... params)const
+        {
+            const Snapshot_guard snapshot = Snapshot();
+            const std::vector<DelegateSingle_Type>& dels = *snapshot;
+            if constexpr (std::is_void_v<Ty_ret>)
+            {
+                for (const auto& del : dels)
+                    del.InvokeUnchecked(params...);
+            }
+            else
+            {
+                if (dels.empty())
+                    throwBadInvoke();
+                const size_t last = dels.size() - 1;
+                for (size_t i = 0; i < last; i++)
+                    dels[i].InvokeUnchecked(params...);
+                return dels[last].InvokeUnchecked(params...);
+            }
+        }
+        Ty_ret operator()(const Ty_params&... params)const
+        {
+            return Invoke(params...);
+        }
+        bool TryInvoke(const Ty_params&... params)const
+        {
+            const Snapshot_guard snapshot = Snapshot();
+            for (const auto& del : *snapshot)
+                del.InvokeUnchecked(params...);
+            return !snapshot->empty();
+        }
+        //不使用快照，依次复制每一个分片中的委托，解锁后调用
+        void InvokeDirect(const Ty_params&... params)const
+        {
+            std::vector<DelegateSingle_Type> dels;
+            for (size_t i = 0; i < m_shardCount; i++)
+            {
+                const Shard& shard = m_shards[i];
+                {
+                    std::lock_guard<std::mutex> lock(shard.mutex);
+                    dels.assign(shard.dels.begin(), shard.dels.end());
+                }
+                for (const auto& del : dels)
+                    del.InvokeUnchecked(params...);
+            }
+        }
+
+    protected:
+        struct alignas(64) Shard
+        {
+            mutable std::mutex mutex;
+            std::vector<DelegateSingle_Type> dels;
+            std::atomic<size_t> generation{ 0 };        //每次变化加一，在 mutex 下修改
+            mutable std::atomic<size_t> merged{ 0 };    //当前快照合并时的 generation
+        };
+        //合并后的快照，只由持有 m_mergeMutex 的合并方替换
+        using Merged = std::vector<DelegateSingle_Type>;
+
+        Shard& localShard()noexcept
+        {
+            return m_shards[currentShardIndex() % m_shardCount];
+        }
+        bool stale()const noexcept
+        {
+            for (size_t i = 0; i < m_shardCount; i++)
+            {
+                const Shard& shard = m_shards[i];
+                if (shard.generation.load(std::memory_order_acquire) != shard.merged.load(std::memory_order_acquire))
+                    return true;
+            }
+            return false;
+        }
+        void merge()const
+        {
+            std::lock_guard<std::mutex> lock(m_mergeMutex);
+            if (!stale())
+                return;
+            //只有持有 m_mergeMutex 的合并方会替换快照，这里不需要危险指针
+            std::unique_ptr<size_t[]> generations(new size_t[m_shardCount]);
+            std::unique_ptr<Merged> merged(new Merged());
+            merged->reserve(m_snapshot.load(std::memory_order_relaxed)->size() + 4);
+            for (size_t i = 0; i < m_shardCount; i++)
+            {
+                //在分片的锁下读取代数，与复制的内容一致；之后的变化会让下一次 Invoke 重新合并
+                const Shard& shard = m_shards[i];
+                std::lock_guard<std::mutex> shardLock(shard.mutex);
+                merged->insert(merged->end(), shard.dels.begin(), shard.dels.end());
+                generations[i] = shard.generation.load(std::memory_order_relaxed);
+            }
+            m_retired.reserve(m_retired.size() + 1);
+            m_retired.push_back(m_snapshot.exchange(merged.release(), std::memory_order_seq_cst));
+            //先替换快照再记录代数，看到新代数的调用方一定能读到新快照
+            for (size_t i = 0; i < m_shardCount; i++)
+                m_shards[i].merged.store(generations[i], std::memory_order_release);
+            delegate_hazard::Reclaim(m_retired);
+        }
+
+        std::unique_ptr<Shard[]> m_shards;
+        size_t m_shardCount;
+        mutable std::mutex m_mergeMutex;
+        mutable std::vector<const Merged*> m_retired;   //已经被替换、可能仍有调用方在使用的快照
+        mutable std::atomic<const Merged*> m_snapshot;
+    };
+}
@@ -0,0 +1,477 @@
+/*
+    基于共享内存的跨进程事件总线（Linux）
+    用法示例:
+        struct PriceTick { int symbol; double price; };     //只能传递可以平凡复制的类型
+
+        //每个进程中
+        SharedEventBus bus("/prices");                      //不存在时创建，存在时打开
+        bus.Register<PriceTick>(1) += { book, &Book::OnTick }; //把消息 id 1 映射到本进程的委托
+        ...
+        bus.Publish(1, PriceTick{ 7, 10.5 });               //任意进程、任意线程发布
+        ...
+        bus.Wait();                                         //阻塞等待新消息
+        bus.Poll();                                         //调用本进程中注册的委托
+
+    其他:
+        1、委托中保存的是本进程中的指针，无法跨进程传递，所以跨进程传递的只有消息 id 和
+           数据。每个进程通过 Register 建立消息 id 到本进程委托的映射，收到没有注册的 id
+           时忽略。
+        2、共享内存中是一个多生产者的广播环形队列，每个进程各自维护读取位置，发布时
+           不会等待读取方。读取方落后超过队列容量时会丢失最旧的消息，丢失的数量可以通过
+           GetLostCount 查询。发布方先用 CAS 把槽位从上一圈写完的状态改为正在写入，占用成功
+           后才推进写入位置，两个相差一圈的发布方不会同时写入同一个槽位；上一圈的发布方还没
+           有写完时，发布方让出时间片等待。
+        3、Poll 先把消息复制到本进程的缓冲区，确认复制过程中没有被发布方覆盖后才调用委托，
+           被覆盖的消息计为丢失。委托收到的参数引用的是这个缓冲区，只在调用过程中有效，需要
+           保存时应自行复制。缓冲区在第一次 Poll 时分配，之后重复使用，委托中再次调用 Poll
+           时使用另一个缓冲区。
+        4、Wait 使用 futex 等待，发布时只有存在等待者才会进行唤醒的系统调用。
+        5、除了通过名字打开（shm_open）以外，也可以用 CreateAnonymous 创建一个 memfd，
+           通过 fork 或 unix 套接字把文件描述符传给其他进程，再用 SharedEventBus(fd) 打开。
+        6、Poll 和 Wait 只能在一个线程中调用，Publish 可以在任意线程中调用。
+        7、发布方占用了一个位置但一直没有写完（例如写入过程中进程退出）时，读取方在该位置
+           等待超过 SetStallTimeout 设置的时间（默认 100 毫秒）后跳过它，计为丢失一条消息。
+           在此期间 Pending 返回 true，但 Poll 不会读到后面的消息。发布方等待上一圈的发布方
+           超过同样的时间后，也认为它已经退出，直接占用该槽位，被占用的发布方的消息会丢失，
+           Publish 返回 false。*/
+#pragma once
+#include<atomic>
+#include<memory>
+#include<chrono>
+#include<vector>
+#include<cstdint>
+#include<cstddef>
+#include<cstring>
+#include<climits>
+#include<stdexcept>
+#include<system_error>
+#include<type_traits>
+#include<unordered_map>
+#include"delegate.hpp"
+#if MYCODES_DELEGATE_LANG < 201703L
+#error(delegate_shared_bus.hpp：请使用c++17及以上的版本)
+#endif
+#if !defined(__linux__)
+#error(delegate_shared_bus.hpp：只支持 Linux)
+#endif
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sched.h>
+#include<sys/stat.h>
+#include<sys/syscall.h>
+#include<linux/futex.h>
+
+namespace MyCodes
+{
+    class SharedEventBus //跨进程事件总线
+    {
+    public:
+        //name 为 shm_open 使用的名字，capacity 会向上取整为 2 的幂
+        SharedEventBus(const char* name, size_t capacity = 4096, size_t payloadSize = 240)
+        {
+            bool created = true;
+            int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+            if (fd < 0 && errno == EEXIST)
+            {
+                created = false;
+                fd = shm_open(name, O_RDWR, 0600);
+            }
+            if (fd < 0)
+                throw std::system_error(errno, std::system_category(), "shm_open");
+            attach(fd, created, capacity, payloadSize);
+        }
+        //打开由 CreateAnonymous 创建并传递过来的文件描述符，会复制该描述符
+        explicit SharedEventBus(int fd)
+        {
+            const int _fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+            if (_fd < 0)
+                throw std::system_error(errno, std::system_category(), "fcntl");
+            attach(_fd, false, 0, 0);
+        }
+        //创建匿名的共享内存（memfd），返回文件描述符
+        static int CreateAnonymous(size_t capacity = 4096, size_t payloadSize = 240)
+        {
+            const int fd = static_cast<int>(syscall(SYS_memfd_create, "delegate_shared_bus", 0));
+            if (fd < 0)
+                throw std::system_error(errno, std::system_category(), "memfd_create");
+            SharedEventBus init(fd, capacity, payloadSize);
+            return fd;
+        }
+        SharedEventBus(const SharedEventBus&) = delete;
+        SharedEventBus& operator=(const SharedEventBus&) = delete;
+        ~SharedEventBus()
+        {
+            if (m_header != nullptr)
+                munmap(m_header, m_mapSize);
+            if (m_fd >= 0)
+                close(m_fd);
+        }
+        //删除 shm_open 创建的名字，已经打开的进程不受影响
+        static void Unlink(const char* name)noexcept
+        {
+            shm_unlink(name);
+        }
+
+        //建立消息 id 到本进程委托的映射，返回该委托
+        template<class T>
+        Delegate<void, const T&>& Register(uint32_t id)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "SharedEventBus：消息类型需要可以平凡复制");
+            auto& handler = m_handlers[id];
+            if (handler == nullptr)
+                handler.reset(new Handler<T>());
+            Handler<T>* typed = dynamic_cast<Handler<T>*>(handler.get());
+            if (typed == nullptr)
+                throw std::logic_error("SharedEventBus：同一个消息 id 注册了不同的类型");
+            return typed->del;
+        }
+        void Unregister(uint32_t id)
+        {
+            m_handlers.erase(id);
+        }
+
+        //发布消息，数据超过 PayloadSize，或者写入过程中槽位被其他发布方接管时返回 false
+        bool Publish(uint32_t id, const void* data, size_t size)noexcept
+        {
+            if (size > m_header->payloadSize)
+                return false;
+
+            const uint64_t pos = claim();
+            Slot& slot = slotAt(pos);
+            //奇数表示正在写入，偶数表示 pos 对应的消息已经写入完毕
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.id = id;
+            slot.size = static_cast<uint32_t>(size);
+            std::memcpy(slot.payload(), data, size);
+            uint64_t writing = pos * 2 + 1;
+            if (!slot.seq.compare_exchange_strong(writing, pos * 2 + 2, std::memory_order_release, std::memory_order_relaxed))
+                return false;
+
+            //与 Wait 中的 waiters、signal 构成顺序一致的读写：要么这里看到等待者，要么等待者看到新的 signal
+            m_header->signal.fetch_add(1, std::memory_order_seq_cst);
+            if (m_header->waiters.load(std::memory_order_seq_cst) != 0)
+                futex(&m_header->signal, FUTEX_WAKE, INT_MAX, nullptr);
+            return true;
+        }
+        template<class T>
+        bool Publish(uint32_t id, const T& data)noexcept
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "SharedEventBus：消息类型需要可以平凡复制");
+            return Publish(id, &data, sizeof(T));
+        }
+
+        //调用本进程中注册的委托，返回读取的消息数量
+        size_t Poll(size_t maxBatch = SIZE_MAX)
+        {
+            //每一层 Poll 使用自己的缓冲区，委托中再次调用 Poll 不会覆盖正在使用的数据
+            if (m_depth == m_buffers.size())
+                m_buffers.emplace_back(new std::max_align_t[(m_header->payloadSize + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t)]);
+            Depth_guard depth{ m_depth };
+            std::max_align_t* buffer = m_buffers[m_depth++].get();
+            size_t count = 0;
+            while (count < maxBatch)
+            {
+                const Slot& slot = slotAt(m_cursor);
+                const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+                const uint64_t ready = m_cursor * 2 + 2;
+                if (seq > ready)
+                {
+                    skipLapped();
+                    continue;
+                }
+                if (seq < ready)
+                {
+                    //没有新消息，或者发布方已经占用了该位置但还没有写完
+                    if (m_header->enqueue.load(std::memory_order_acquire) <= m_cursor || !stalled())
+                        break;
+                    m_lost++;
+                    m_cursor++;
+                    continue;
+                }
+
+                const uint32_t id = slot.id;
+                const uint32_t size = slot.size;
+                if (size <= m_header->payloadSize)
+                    std::memcpy(buffer, slot.payload(), size);
+                //复制后再次检查，数据在复制过程中被覆盖时计为丢失
+                std::atomic_thread_fence(std::memory_order_acquire);
+                const bool intact = size <= m_header->payloadSize && slot.seq.load(std::memory_order_relaxed) == ready;
+                m_cursor++;
+                if (!intact)
+                {
+                    m_lost++;
+                    continue;
+                }
+
+                count++;
+                auto it = m_handlers.find(id);
+                if (it != m_handlers.end() && it->second->size == size)
+                    it->second->Dispatch(buffer);
+            }
+            return count;
+        }
+        //阻塞直到有新消息或超时，返回是否有新消息
+        bool Wait(std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max())
+        {
+            //只计算一次截止时间，被信号中断或虚假唤醒后继续等待剩余的时间
+            using clock = std::chrono::steady_clock;
+            const clock::time_point now = clock::now();
+            const bool infinite = timeout >= clock::time_point::max() - now;
+            const clock::time_point deadline = infinite ? clock::time_point::max() : now + timeout;
+            for (;;)
+            {
+                const uint32_t signal = m_header->signal.load(std::memory_order_acquire);
+                if (Pending())
+                    return true;
+
+                timespec ts;
+                timespec* pts = nullptr;
+                if (!infinite)
+                {
+                    const auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - clock::now());
+                    if (remaining.count() <= 0)
+                        return Pending();
+                    ts.tv_sec = static_cast<time_t>(remaining.count() / 1000000000);
+                    ts.tv_nsec = static_cast<long>(remaining.count() % 1000000000);
+                    pts = &ts;
+                }
+                m_header->waiters.fetch_add(1, std::memory_order_seq_cst);
+                futex(&m_header->signal, FUTEX_WAIT, signal, pts);
+                m_header->waiters.fetch_sub(1, std::memory_order_seq_cst);
+            }
+        }
+        //是否有已经发布（或正在发布）的消息没有读取
+        bool Pending()const noexcept
+        {
+            return m_header->enqueue.load(std::memory_order_acquire) > m_cursor;
+        }
+        //发布方占用位置后超过 timeout 仍没有写完时，跳过该位置
+        void SetStallTimeout(std::chrono::nanoseconds timeout)noexcept
+        {
+            m_stallTimeout = timeout;
+        }
+
+        size_t GetLostCount()const noexcept
+        {
+            return m_lost;
+        }
+        size_t Capacity()const noexcept
+        {
+            return m_header->capacity;
+        }
+        size_t PayloadSize()const noexcept
+        {
+            return m_header->payloadSize;
+        }
+
+    protected:
+        static constexpr uint64_t magic = 0x4d79436f64657342ull;
+
+        struct alignas(64) Header
+        {
+            std::atomic<uint64_t> magic;
+            uint64_t capacity;
+            uint64_t payloadSize;
+            uint64_t slotStride;
+            alignas(64) std::atomic<uint64_t> enqueue;
+            alignas(64) std::atomic<uint32_t> signal;
+            std::atomic<uint32_t> waiters;
+        };
+        struct Slot
+        {
+            std::atomic<uint64_t> seq;
+            uint32_t id;
+            uint32_t size;
+            unsigned char* payload()noexcept
+            {
+                return reinterpret_cast<unsigned char*>(this + 1);
+            }
+            const unsigned char* payload()const noexcept
+            {
+                return reinterpret_cast<const unsigned char*>(this + 1);
+            }
+        };
+        static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+            "SharedEventBus：共享内存中需要无锁的原子类型");
+
+        struct Handler_base
+        {
+            virtual ~Handler_base() = default;
+            virtual void Dispatch(const void* data)const = 0;
+            uint32_t size = 0;
+        };
+        struct Depth_guard
+        {
+            ~Depth_guard()
+            {
+                depth--;
+            }
+            size_t& depth;
+        };
+
+        template<class T>
+        struct Handler :Handler_base
+        {
+            Handler()noexcept
+            {
+                this->size = sizeof(T);
+            }
+            void Dispatch(const void* data)const override
+            {
+                del.Invoke(*reinterpret_cast<const T*>(data));
+            }
+            Delegate<void, const T&> del;
+        };
+
+        //仅供 CreateAnonymous 初始化使用，不复制描述符，也不关闭
+        SharedEventBus(int fd, size_t capacity, size_t payloadSize)
+        {
+            attach(fd, true, capacity, payloadSize);
+            m_fd = -1;
+        }
+
+        static long futex(std::atomic<uint32_t>* addr, int op, uint32_t value, const timespec* timeout)noexcept
+        {
+            return syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), op, value, timeout, nullptr, 0);
+        }
+
+        void attach(int fd, bool create, size_t capacity, size_t payloadSize)
+        {
+            m_fd = fd;
+            if (create)
+            {
+                size_t size = 2;
+                while (size < capacity)
+                    size <<= 1;
+                const size_t stride = (sizeof(Slot) + payloadSize + 63) / 64 * 64;
+                m_mapSize = sizeof(Header) + size * stride;
+                if (ftruncate(fd, static_cast<off_t>(m_mapSize)) != 0)
+                    throw std::system_error(errno, std::system_category(), "ftruncate");
+                map();
+                m_header->capacity = size;
+                m_header->payloadSize = stride - sizeof(Slot);
+                m_header->slotStride = stride;
+                m_header->enqueue.store(0, std::memory_order_relaxed);
+                m_header->signal.store(0, std::memory_order_relaxed);
+                m_header->waiters.store(0, std::memory_order_relaxed);
+                for (uint64_t i = 0; i < size; i++)
+                    slotAt(i).seq.store(0, std::memory_order_relaxed);
+                m_header->magic.store(magic, std::memory_order_release);
+            }
+            else
+            {
+                //等待创建者设置好大小并完成初始化
+                struct stat st;
+                do
+                {
+                    if (fstat(fd, &st) != 0)
+                        throw std::system_error(errno, std::system_category(), "fstat");
+                } while (static_cast<size_t>(st.st_size) < sizeof(Header));
+                m_mapSize = static_cast<size_t>(st.st_size);
+                map();
+                while (m_header->magic.load(std::memory_order_acquire) != magic)
+                    sched_yield();
+            }
+            m_cursor = m_header->enqueue.load(std::memory_order_acquire);
+        }
+        void map()
+        {
+            void* addr = mmap(nullptr, m_mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+            if (addr == MAP_FAILED)
+                throw std::system_error(errno, std::system_category(), "mmap");
+            m_header = static_cast<Header*>(addr);
+            m_slots = reinterpret_cast<unsigned char*>(m_header) + sizeof(Header);
+        }
+
+        Slot& slotAt(uint64_t pos)const noexcept
+        {
+            return *reinterpret_cast<Slot*>(m_slots + (pos & (m_header->capacity - 1)) * m_header->slotStride);
+        }
+        //占用一个写入位置：先把槽位从上一圈写完的状态 CAS 为正在写入，再推进 enqueue
+        uint64_t claim()noexcept
+        {
+            const uint64_t capacity = m_header->capacity;
+            uint64_t pos = m_header->enqueue.load(std::memory_order_relaxed);
+            uint64_t stallPos = UINT64_MAX;
+            std::chrono::steady_clock::time_point stallSince;
+            for (;;)
+            {
+                Slot& slot = slotAt(pos);
+                const uint64_t free = pos < capacity ? 0 : (pos - capacity) * 2 + 2;
+                uint64_t seq = slot.seq.load(std::memory_order_acquire);
+                bool take = seq == free;
+                if (seq < free)
+                {
+                    //上一圈的发布方还没有写完，等待超时后认为它已经退出
+                    const auto now = std::chrono::steady_clock::now();
+                    if (stallPos != pos)
+                    {
+                        stallPos = pos;
+                        stallSince = now;
+                    }
+                    take = now - stallSince >= m_stallTimeout;
+                    if (!take)
+                    {
+                        sched_yield();
+                        pos = m_header->enqueue.load(std::memory_order_relaxed);
+                        continue;
+                    }
+                }
+                if (take && slot.seq.compare_exchange_strong(seq, pos * 2 + 1, std::memory_order_acquire, std::memory_order_relaxed))
+                {
+                    uint64_t expected = pos;
+                    m_header->enqueue.compare_exchange_strong(expected, pos + 1, std::memory_order_release, std::memory_order_relaxed);
+                    return pos;
+                }
+                //pos 已经被其他发布方占用，帮助它推进 enqueue 后重试
+                uint64_t expected = pos;
+                if (m_header->enqueue.compare_exchange_strong(expected, pos + 1, std::memory_order_release, std::memory_order_relaxed))
+                    pos++;
+                else
+                    pos = expected;
+            }
+        }
+        //读取位置被发布方超过一圈时，跳到仍然有效的最旧的消息
+        void skipLapped()noexcept
+        {
+            const uint64_t oldest = m_header->enqueue.load(std::memory_order_acquire) - m_header->capacity;
+            if (oldest > m_cursor)
+            {
+                m_lost += static_cast<size_t>(oldest - m_cursor);
+                m_cursor = oldest;
+            }
+            else
+            {
+                m_lost++;
+                m_cursor++;
+            }
+        }
+
+        //读取位置在 m_stallCursor 处从 m_stallSince 开始等待发布方写完
+        bool stalled()noexcept
+        {
+            const auto now = std::chrono::steady_clock::now();
+            if (m_stallCursor != m_cursor)
+            {
+                m_stallCursor = m_cursor;
+                m_stallSince = now;
+                return false;
+            }
+            return now - m_stallSince >= m_stallTimeout;
+        }
+
+        int m_fd = -1;
+        size_t m_mapSize = 0;
+        Header* m_header = nullptr;
+        unsigned char* m_slots = nullptr;
+        uint64_t m_cursor = 0;
+        size_t m_lost = 0;
+        std::chrono::nanoseconds m_stallTimeout = std::chrono::milliseconds(100);
+        uint64_t m_stallCursor = UINT64_MAX;
+        std::chrono::steady_clock::time_point m_stallSince;
+        std::vector<std::unique_ptr<std::max_align_t[]>> m_buffers;    //每一层 Poll 的缓冲区
+        size_t m_depth = 0;
+        std::unordered_map<uint32_t, std::unique_ptr<Handler_base>> m_handlers;
+    };
+}
@@ -0,0 +1,278 @@
+/*
+    编译期确定订阅者的多播委托
+    用法示例:
+        void OnHit(int damage);
+        struct Hud { void Update(int damage); } hud;
+        StaticDelegate<&OnHit, &Hud::Update> del(hud);  //类成员函数按顺序传入对象
+        del(10);                                        //依次直接调用 OnHit 和 hud.Update，可以被内联
+
+    其他:
+        1、模板参数为函数指针或类成员函数指针，委托的签名由第一个模板参数决定，
+           后面的函数必须可以用相同的参数调用。构造时需要为每一个类成员函数按顺序传入
+           对应的对象，普通函数不需要。
+        2、StaticDelegate 可以是 constexpr 对象（此时绑定的对象需要具有静态存储期），
+           Invoke 是对所有目标的直接调用展开，没有数组遍历，也没有通过函数指针的间接调用。
+        3、需要在运行时添加订阅者时，可以用 ToDelegate（或隐式转换）得到一个包含相同订阅者
+           的 Delegate，或者使用 HybridDelegate：它先调用编译期确定的订阅者，再调用运行时
+           添加的订阅者，运行时部分可以通过 GetView 得到的 Delegate_view 注册或删除。
+        4、返回值不为 void 时，返回最后一个被调用的订阅者的返回值。
+*/
+#pragma once
+#include<tuple>
+#include<utility>
+#include<type_traits>
+#include"delegate.hpp"
+#if MYCODES_DELEGATE_LANG < 201703L
+#error(delegate_static.hpp：请使用c++17及以上的版本)
+#endif
+
+namespace MyCodes
+{
+    //按签名生成 Invoke，Derived 需要提供 invokeAll
+    template<class Derived, class Ty_ret, class...Ty_params>
+    class StaticDelegate_invoker
+    {
+    public:
+        using ret_type = Ty_ret;
+        using DelegateType = Delegate<Ty_ret, Ty_params...>;
+        using ViewType = Delegate_view<Ty_ret, Ty_params...>;
+
+        //触发调用
+        constexpr Ty_ret Invoke(const Ty_params&... params)const
+        {
+            return static_cast<const Derived&>(*this).invokeAll(params...);
+        }
+        constexpr Ty_ret operator()(const Ty_params&... params)const
+        {
+            return Invoke(params...);
+        }
+    };
+
+    //萃取函数指针和类成员函数指针的返回值、参数和所属类
+    template<class FunType>
+    struct static_fun_traits;
+
+    template<class Ty_ret, class...Ty_params>
+    struct static_fun_traits<Ty_ret(*)(Ty_params...)>
+    {
+        using slot_type = Empty;
+        template<class Derived>
+        using invoker = StaticDelegate_invoker<Derived, Ty_ret, Ty_params...>;
+        static constexpr bool is_member = false;
+    };
+    template<class Ty_ret, class...Ty_params>
+    struct static_fun_traits<Ty_ret(*)(Ty_params...)noexcept> :static_fun_traits<Ty_ret(*)(Ty_params...)>
+    {
+    };
+    template<class Ty_ret, class CLS, class...Ty_params>
+    struct static_fun_traits<Ty_ret(CLS::*)(Ty_params...)>
+    {
+        using slot_type = CLS*;
+        template<class Derived>
+        using invoker = StaticDelegate_invoker<Derived, Ty_ret, Ty_params...>;
+        static constexpr bool is_member = true;
+    };
+    template<class Ty_ret, class CLS, class...Ty_params>
+    struct static_fun_traits<Ty_ret(CLS::*)(Ty_params...)const>
+    {
+        using slot_type = const CLS*;
+        template<class Derived>
+        using invoker = StaticDelegate_invoker<Derived, Ty_ret, Ty_params...>;
+        static constexpr bool is_member = true;
+    };
+    template<class Ty_ret, class CLS, class...Ty_params>
+    struct static_fun_traits<Ty_ret(CLS::*)(Ty_params...)noexcept> :static_fun_traits<Ty_ret(CLS::*)(Ty_params...)>
+    {
+    };
+    template<class Ty_ret, class CLS, class...Ty_params>
+    struct static_fun_traits<Ty_ret(CLS::*)(Ty_params...)const noexcept> :static_fun_traits<Ty_ret(CLS::*)(Ty_params...)const>
+    {
+    };
+
+    template<auto Fun, auto...Funs>
+    class StaticDelegate :public static_fun_traits<decltype(Fun)>::template invoker<StaticDelegate<Fun, Funs...>> //编译期多播委托
+    {
+        using Invoker = typename static_fun_traits<decltype(Fun)>::template invoker<StaticDelegate>;
+        friend Invoker;
+        template<auto, auto...>
+        friend class HybridDelegate;
+    public:
+        using typename Invoker::ret_type;
+        using typename Invoker::DelegateType;
+
+        static constexpr size_t count = sizeof...(Funs) + 1;
+
+        //没有类成员函数时不需要传入对象
+        constexpr StaticDelegate()noexcept
+            :m_slots()
+        {
+            static_assert(memberCount() == 0, "StaticDelegate：传入的对象数量与类成员函数的数量不一致");
+        }
+        //为每一个类成员函数按顺序传入对应的对象，不会与复制构造函数混淆
+        template<class Obj, class...Objs, std::enable_if_t<!std::is_base_of_v<StaticDelegate, std::remove_cv_t<Obj>>, int> = 0>
+        constexpr StaticDelegate(Obj& obj, Objs&... objs)noexcept
+            :m_slots(makeSlots(std::make_index_sequence<count>(), std::tie(obj, objs...)))
+        {
+            static_assert(sizeof...(Objs) + 1 == memberCount(), "StaticDelegate：传入的对象数量与类成员函数的数量不一致");
+        }
+
+        //把所有订阅者依次添加到运行时的委托中
+        template<class DelegateBase>
+        void AddTo(DelegateBase& del)const
+        {
+            addTo(del, std::make_index_sequence<count>());
+        }
+        DelegateType ToDelegate()const
+        {
+            DelegateType del(count);
+            AddTo(del);
+            return del;
+        }
+        operator DelegateType()const
+        {
+            return ToDelegate();
+        }
+
+    protected:
+        using Funs_tuple = std::tuple<decltype(Fun), decltype(Funs)...>;
+        using Slots = std::tuple<typename static_fun_traits<decltype(Fun)>::slot_type,
+            typename static_fun_traits<decltype(Funs)>::slot_type...>;
+
+        template<size_t I>
+        static constexpr std::tuple_element_t<I, Funs_tuple> target = std::get<I>(Funs_tuple(Fun, Funs...));
+        template<size_t I>
+        static constexpr bool is_member = static_fun_traits<std::tuple_element_t<I, Funs_tuple>>::is_member;
+
+        static constexpr size_t memberCount()noexcept
+        {
+            return (size_t(static_fun_traits<decltype(Fun)>::is_member) + ... +
+                size_t(static_fun_traits<decltype(Funs)>::is_member));
+        }
+        //第 I 个目标之前有几个类成员函数，即第 I 个目标对应的对象下标
+        static constexpr size_t memberIndex(size_t I)noexcept
+        {
+            constexpr bool members[] = { static_fun_traits<decltype(Fun)>::is_member,
+                static_fun_traits<decltype(Funs)>::is_member... };
+            size_t index = 0;
+            for (size_t i = 0; i < I; i++)
+                index += members[i];
+            return index;
+        }
+
+        template<size_t I, class Refs>
+        static constexpr auto makeSlot(const Refs& refs)noexcept
+        {
+            using Slot = std::tuple_element_t<I, Slots>;
+            if constexpr (is_member<I>)
+            {
+                //隐式转换：对象的类型不匹配或丢失 const 时编译失败，而不是强制转换
+                const Slot slot = &std::get<memberIndex(I)>(refs);
+                return slot;
+            }
+            else
+                return Slot();
+        }
+        template<size_t...Is, class Refs>
+        static constexpr Slots makeSlots(std::index_sequence<Is...>, const Refs& refs)noexcept
+        {
+            return Slots(makeSlot<Is>(refs)...);
+        }
+
+        template<size_t I, class...Ty_params>
+        constexpr ret_type call(const Ty_params&... params)const
+        {
+            if constexpr (is_member<I>)
+                return (std::get<I>(m_slots)->*target<I>)(params...);
+            else
+                return target<I>(params...);
+        }
+        template<class...Ty_params>
+        constexpr ret_type invokeAll(const Ty_params&... params)const
+        {
+            return invokeAll(std::make_index_sequence<count - 1>(), params...);
+        }
+        template<size_t...Is, class...Ty_params>
+        constexpr ret_type invokeAll(std::index_sequence<Is...>, const Ty_params&... params)const
+        {
+            //除最后一个以外的目标丢弃返回值，最后一个目标的返回值作为整体的返回值
+            ((void)call<Is>(params...), ...);
+            return call<count - 1>(params...);
+        }
+
+        template<class DelegateBase, size_t...Is>
+        void addTo(DelegateBase& del, std::index_sequence<Is...>)const
+        {
+            (addOne<Is>(del), ...);
+        }
+        template<size_t I, class DelegateBase>
+        void addOne(DelegateBase& del)const
+        {
+            if constexpr (is_member<I>)
+                del.Add(*std::get<I>(m_slots), target<I>);
+            else
+                del.Add(target<I>);
+        }
+
+        Slots m_slots;
+    };
+
+    template<auto Fun, auto...Funs>
+    class HybridDelegate :public static_fun_traits<decltype(Fun)>::template invoker<HybridDelegate<Fun, Funs...>> //编译期订阅者加上运行时订阅者
+    {
+        using Invoker = typename static_fun_traits<decltype(Fun)>::template invoker<HybridDelegate>;
+        friend Invoker;
+    public:
+        using typename Invoker::ret_type;
+        using typename Invoker::DelegateType;
+        using typename Invoker::ViewType;
+
+        HybridDelegate()noexcept
+            :m_static()
+        {
+        }
+        template<class Obj, class...Objs, std::enable_if_t<!std::is_base_of_v<HybridDelegate, std::remove_cv_t<Obj>>, int> = 0>
+        HybridDelegate(Obj& obj, Objs&... objs)noexcept
+            :m_static(obj, objs...)
+        {
+        }
+
+        const StaticDelegate<Fun, Funs...>& GetStatic()const noexcept
+        {
+            return m_static;
+        }
+        //运行时添加的订阅者
+        DelegateType& GetDynamic()noexcept
+        {
+            return m_dynamic;
+        }
+        const DelegateType& GetDynamic()const noexcept
+        {
+            return m_dynamic;
+        }
+        ViewType GetView()noexcept
+        {
+            return ViewType(m_dynamic);
+        }
+
+    protected:
+        template<class...Ty_params>
+        ret_type invokeAll(const Ty_params&... params)const
+        {
+            if constexpr (std::is_void_v<ret_type>)
+            {
+                m_static.invokeAll(params...);
+                m_dynamic.Invoke(params...);
+            }
+            else
+            {
+                if (m_dynamic.Empty())
+                    return m_static.invokeAll(params...);
+                m_static.invokeAll(params...);
+                return m_dynamic.Invoke(params...);
+            }
+        }
+
+        StaticDelegate<Fun, Funs...> m_static;
+        DelegateType m_dynamic;
+    };
+}
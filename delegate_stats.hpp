@@ -0,0 +1,194 @@
+/*
+    统计进程中所有多播委托的数量和内存占用
+    用法示例:
+        #define MYCODES_DELEGATE_STATS          //需要在包含 delegate.hpp 之前定义（建议在项目设置中定义）
+        #include"delegate_stats.hpp"
+        auto report = DelegateStats(10);        //统计所有存活的多播委托，并列出订阅者最多的 10 个
+        puts(report.ToText().c_str());
+        fputs(report.ToJson().c_str(), file);
+
+    其他:
+        1、定义了 MYCODES_DELEGATE_STATS 后，每个多播委托在构造时登记到一个全局的侵入式链表中，
+           析构时移除，登记只需要一次加锁，不分配内存。未定义该宏时多播委托没有任何额外开销，
+           也不能包含本头文件。
+        2、同一个项目中所有翻译单元必须一致地定义或不定义 MYCODES_DELEGATE_STATS，否则多播委托
+           的内存布局不一致。
+        3、多播委托每次修改订阅者数组（Add、Sub、Clear 等）后，用 relaxed 的原子写把数量和容量
+           更新到登记节点中；DelegateStats 持有全局锁遍历链表，只读取这些原子副本，不访问委托本身，
+           因此可以在任意线程中调用，其他线程同时修改委托也是安全的。结果是调用时刻的快照，各个
+           委托的数值不是在同一瞬间读取的。构造和析构会等待统计结束。
+        4、bytes_used 和 bytes_reserved 只计算订阅者数组本身（size 和 capacity 乘以单个委托的大小），
+           不包含多播委托对象自身的大小，signature 为编译器给出的类型名称。
+*/
+#pragma once
+#include<string>
+#include<vector>
+#include<cstdio>
+#include<algorithm>
+#include<unordered_map>
+#include"delegate.hpp"
+#if !defined(MYCODES_DELEGATE_STATS)
+#error(delegate_stats.hpp：请在包含 delegate.hpp 之前定义 MYCODES_DELEGATE_STATS)
+#endif
+
+namespace MyCodes
+{
+    struct delegate_stats_signature //同一签名的多播委托的合计
+    {
+        const char* signature;
+        size_t events;
+        size_t subscribers;
+        size_t capacity;
+        size_t bytes_used;
+        size_t bytes_reserved;
+    };
+
+    struct delegate_stats_report
+    {
+        size_t events = 0;              //存活的多播委托数量
+        size_t subscribers = 0;         //所有订阅者数量
+        size_t capacity = 0;            //所有订阅者数组的容量
+        size_t bytes_used = 0;
+        size_t bytes_reserved = 0;
+        std::vector<delegate_stats_signature> signatures;   //按 bytes_reserved 从大到小排列
+        std::vector<delegate_stats_entry> largest;          //订阅者最多的多播委托
+
+        std::string ToText()const
+        {
+            std::string text;
+            text += "events: " + std::to_string(events)
+                + ", subscribers: " + std::to_string(subscribers)
+                + ", capacity: " + std::to_string(capacity)
+                + ", bytes used: " + std::to_string(bytes_used)
+                + ", bytes reserved: " + std::to_string(bytes_reserved) + "\n";
+            text += "by signature:\n";
+            for (const auto& sig : signatures)
+            {
+                text += "  " + std::to_string(sig.events) + " events, "
+                    + std::to_string(sig.subscribers) + "/" + std::to_string(sig.capacity) + " subscribers, "
+                    + std::to_string(sig.bytes_reserved) + " bytes  " + sig.signature + "\n";
+            }
+            text += "largest:\n";
+            for (const auto& entry : largest)
+            {
+                char address[2 * sizeof(void*) + 3];
+                snprintf(address, sizeof(address), "%p", entry.address);
+                text += "  " + std::string(address) + "  "
+                    + std::to_string(entry.size) + "/" + std::to_string(entry.capacity) + " subscribers  "
+                    + entry.signature + "\n";
+            }
+            return text;
+        }
+
+        std::string ToJson()const
+        {
+            std::string json;
+            json += "{\"events\":" + std::to_string(events)
+                + ",\"subscribers\":" + std::to_string(subscribers)
+                + ",\"capacity\":" + std::to_string(capacity)
+                + ",\"bytes_used\":" + std::to_string(bytes_used)
+                + ",\"bytes_reserved\":" + std::to_string(bytes_reserved)
+                + ",\"signatures\":[";
+            for (size_t i = 0; i < signatures.size(); i++)
+            {
+                const auto& sig = signatures[i];
+                json += i == 0 ? "{" : ",{";
+                json += "\"signature\":" + jsonString(sig.signature)
+                    + ",\"events\":" + std::to_string(sig.events)
+                    + ",\"subscribers\":" + std::to_string(sig.subscribers)
+                    + ",\"capacity\":" + std::to_string(sig.capacity)
+                    + ",\"bytes_used\":" + std::to_string(sig.bytes_used)
+                    + ",\"bytes_reserved\":" + std::to_string(sig.bytes_reserved) + "}";
+            }
+            json += "],\"largest\":[";
+            for (size_t i = 0; i < largest.size(); i++)
+            {
+                const auto& entry = largest[i];
+                char address[2 * sizeof(void*) + 3];
+                snprintf(address, sizeof(address), "%p", entry.address);
+                json += i == 0 ? "{" : ",{";
+                json += "\"address\":" + jsonString(address)
+                    + ",\"signature\":" + jsonString(entry.signature)
+                    + ",\"subscribers\":" + std::to_string(entry.size)
+                    + ",\"capacity\":" + std::to_string(entry.capacity)
+                    + ",\"bytes_reserved\":" + std::to_string(entry.capacity * entry.elem_size) + "}";
+            }
+            json += "]}";
+            return json;
+        }
+
+    protected:
+        static std::string jsonString(const char* str)
+        {
+            std::string out = "\"";
+            for (; *str != '\0'; str++)
+            {
+                const char c = *str;
+                if (c == '"' || c == '\\')
+                {
+                    out += '\\';
+                    out += c;
+                }
+                else if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                    out += escaped;
+                }
+                else
+                    out += c;
+            }
+            out += '"';
+            return out;
+        }
+    };
+
+    //统计所有存活的多播委托，top 为 largest 中保留的数量
+    inline delegate_stats_report DelegateStats(size_t top = 10)
+    {
+        delegate_stats_report report;
+        std::unordered_map<const char*, size_t> index;  //同一签名的 typeid 名称指针相同
+        delegate_stats_hook::ForEach([&](const delegate_stats_entry& entry)
+            {
+                report.events++;
+                report.subscribers += entry.size;
+                report.capacity += entry.capacity;
+                report.bytes_used += entry.size * entry.elem_size;
+                report.bytes_reserved += entry.capacity * entry.elem_size;
+
+                auto it = index.find(entry.signature);
+                if (it == index.end())
+                {
+                    it = index.emplace(entry.signature, report.signatures.size()).first;
+                    report.signatures.push_back({ entry.signature, 0, 0, 0, 0, 0 });
+                }
+                delegate_stats_signature& sig = report.signatures[it->second];
+                sig.events++;
+                sig.subscribers += entry.size;
+                sig.capacity += entry.capacity;
+                sig.bytes_used += entry.size * entry.elem_size;
+                sig.bytes_reserved += entry.capacity * entry.elem_size;
+
+                if (top == 0)
+                    return;
+                //largest 保持为按订阅者数量从大到小排列的前 top 个
+                auto greater = [](const delegate_stats_entry& left, const delegate_stats_entry& right)
+                {
+                    return left.size > right.size;
+                };
+                if (report.largest.size() == top)
+                {
+                    if (entry.size <= report.largest.back().size)
+                        return;
+                    report.largest.pop_back();
+                }
+                report.largest.insert(std::upper_bound(report.largest.begin(), report.largest.end(), entry, greater), entry);
+            });
+        std::sort(report.signatures.begin(), report.signatures.end(),
+            [](const delegate_stats_signature& left, const delegate_stats_signature& right)
+            {
+                return left.bytes_reserved > right.bytes_reserved;
+            });
+        return report;
+    }
+}
@@ -0,0 +1,359 @@
+/*
+    分层时间轮，用于定时调用委托
+    用法示例:
+        TimerWheel<> wheel;                                 //默认每个刻度为 1 毫秒
+        TimerHandle h = wheel.Schedule(500, { obj, &Obj::OnTimeout });  //500 个刻度后调用一次
+        wheel.Schedule(100, { obj, &Obj::OnTick }, 100);    //100 个刻度后开始，之后每 100 个刻度调用一次
+        wheel.Cancel(h);                                    //取消
+        wheel.Poll();                                       //在每帧（或每次循环）中调用，触发到期的定时器
+
+    其他:
+        1、时间轮共 4 层，每层 256 个槽，第 0 层的每个槽对应一个刻度，上一层的每个槽对应
+           下一层的一整圈。Schedule 和 Cancel 都是 O(1) 的；每前进一个刻度只处理第 0 层
+           的一个槽，每 256 个刻度把上一层的一个槽重新分配到下一层。超过 2^32 个刻度的定时器
+           会先放在最高层，重新分配时再放到正确的位置。
+        2、定时器节点存放在内部的节点池中，取消或触发完毕的节点会被回收，再次 Schedule
+           时直接复用，稳定运行后不再分配内存。可以用 Reserve 预先分配节点。
+        3、TimerHandle 由节点下标和代数组成，节点被回收后代数加一，因此旧的句柄不会误取消
+           复用了同一节点的新定时器。周期定时器每次触发后仍使用同一个句柄。
+        4、Advance 按刻度前进，Poll 根据构造时给定的刻度时长和经过的时间前进。到期的定时器
+           在 Advance/Poll 中按到期顺序调用，同一刻度内的顺序不确定。回调中可以 Schedule 或
+           Cancel 任意定时器（包括自己），延迟为 0 的定时器在下一个刻度触发。回调抛出的异常会
+           中断本次 Advance/Poll，抛出异常的定时器照常重新计时或回收，当前刻度剩余的定时器在
+           下一次 Advance/Poll 开始时触发。
+        5、模板参数为回调的类型，默认是 DelegateSingle<void>，也可以使用 DelegateSingle_any<void>
+           以绑定返回值不为 void 的函数。时间轮本身不是线程安全的。
+*/
+#pragma once
+#include<chrono>
+#include<vector>
+#include<cstdint>
+#include"delegate.hpp"
+#if MYCODES_DELEGATE_LANG < 201703L
+#error(delegate_timer_wheel.hpp：请使用c++17及以上的版本)
+#endif
+
+namespace MyCodes
+{
+    struct TimerHandle
+    {
+        uint32_t index = UINT32_MAX;
+        uint32_t generation = 0;
+
+        bool IsNull()const noexcept
+        {
+            return index == UINT32_MAX;
+        }
+        bool operator==(const TimerHandle& right)const noexcept
+        {
+            return index == right.index && generation == right.generation;
+        }
+        bool operator!=(const TimerHandle& right)const noexcept
+        {
+            return !(*this == right);
+        }
+    };
+
+    template<class Callback = DelegateSingle<void>>
+    class TimerWheel //分层时间轮
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr uint32_t slot_bits = 8;
+        static constexpr uint32_t slot_count = 1u << slot_bits;
+        static constexpr uint32_t level_count = 4;
+
+        TimerWheel(Clock::duration tick = std::chrono::milliseconds(1))
+            :m_tick(tick), m_start(Clock::now())
+        {
+            for (auto& head : m_heads)
+                head = npos;
+        }
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+
+        //delay 个刻度后调用 callback，period 不为 0 时之后每 period 个刻度调用一次
+        TimerHandle Schedule(uint64_t delay, const Callback& callback, uint64_t period = 0)
+        {
+            if (callback.IsNull())
+                return TimerHandle();
+
+            const uint32_t index = allocNode();
+            Node& node = m_nodes[index];
+            node.expire = expireAfter(delay == 0 ? 1 : delay);
+            node.period = period;
+            node.state = State::pending;
+            node.callback = callback;
+            link(index);
+            m_pending++;
+            return TimerHandle{ index, node.generation };
+        }
+
+        //取消定时器，定时器已经触发（非周期）或已被取消时返回 false
+        bool Cancel(const TimerHandle& handle)noexcept
+        {
+            if (!IsPending(handle))
+                return false;
+
+            Node& node = m_nodes[handle.index];
+            if (node.state == State::firing)
+            {
+                //正在执行自己的回调，回调返回后再回收
+                node.state = State::cancelled;
+                return true;
+            }
+            unlink(handle.index);
+            freeNode(handle.index);
+            m_pending--;
+            return true;
+        }
+        bool IsPending(const TimerHandle& handle)const noexcept
+        {
+            if (handle.index >= m_nodes.size())
+                return false;
+            const Node& node = m_nodes[handle.index];
+            return node.generation == handle.generation &&
+                (node.state == State::pending || (node.state == State::firing && node.period != 0));
+        }
+        //距离触发还有多少个刻度
+        uint64_t Remaining(const TimerHandle& handle)const noexcept
+        {
+            if (!IsPending(handle))
+                return 0;
+            const Node& node = m_nodes[handle.index];
+            return node.expire > m_now ? node.expire - m_now : 0;
+        }
+
+        //前进 ticks 个刻度，返回触发的回调数量
+        size_t Advance(uint64_t ticks = 1)
+        {
+            //上一次调用中回调抛出了异常，先触发当前刻度剩余的定时器
+            size_t fired = fireSlot(static_cast<uint32_t>(m_now & (slot_count - 1)));
+            for (; ticks > 0; ticks--)
+            {
+                if (m_pending == 0)
+                {
+                    //没有定时器时直接跳过，不需要逐个刻度处理
+                    m_now += ticks;
+                    break;
+                }
+                m_now++;
+                cascade();
+                fired += fireSlot(static_cast<uint32_t>(m_now & (slot_count - 1)));
+            }
+            return fired;
+        }
+        //根据经过的时间前进
+        size_t Poll(Clock::time_point now = Clock::now())
+        {
+            const uint64_t target = static_cast<uint64_t>((now - m_start) / m_tick);
+            return target > m_now ? Advance(target - m_now) : 0;
+        }
+
+        //当前的刻度
+        uint64_t Now()const noexcept
+        {
+            return m_now;
+        }
+        size_t PendingCount()const noexcept
+        {
+            return m_pending;
+        }
+        bool Empty()const noexcept
+        {
+            return m_pending == 0;
+        }
+        void Reserve(size_t count)
+        {
+            if (count <= m_nodes.size())
+                return;
+            m_nodes.reserve(count);
+            while (m_nodes.size() < count)
+            {
+                m_nodes.emplace_back();
+                m_nodes.back().next = m_free;
+                m_free = static_cast<uint32_t>(m_nodes.size() - 1);
+            }
+        }
+        //取消所有定时器，节点保留在节点池中
+        void Clear()noexcept
+        {
+            //正在执行回调的节点在回调返回后回收，仍计入 m_pending
+            size_t firing = 0;
+            for (uint32_t i = 0; i < m_nodes.size(); i++)
+            {
+                if (m_nodes[i].state == State::pending)
+                    freeNode(i);
+                else if (m_nodes[i].state != State::free)
+                {
+                    m_nodes[i].state = State::cancelled;
+                    firing++;
+                }
+            }
+            for (auto& head : m_heads)
+                head = npos;
+            m_pending = firing;
+        }
+
+    protected:
+        static constexpr uint32_t npos = UINT32_MAX;
+
+        enum class State :uint8_t
+        {
+            free, pending, firing, cancelled
+        };
+
+        struct Node
+        {
+            uint64_t expire = 0;
+            uint64_t period = 0;
+            uint32_t prev = npos;
+            uint32_t next = npos;
+            uint32_t generation = 0;
+            uint16_t slot = 0;      //所在的槽，level * slot_count + index
+            State state = State::free;
+            Callback callback;
+        };
+
+        uint32_t allocNode()
+        {
+            if (m_free == npos)
+            {
+                m_nodes.emplace_back();
+                return static_cast<uint32_t>(m_nodes.size() - 1);
+            }
+            const uint32_t index = m_free;
+            m_free = m_nodes[index].next;
+            return index;
+        }
+        void freeNode(uint32_t index)noexcept
+        {
+            Node& node = m_nodes[index];
+            node.state = State::free;
+            node.generation++;
+            node.callback = Callback();
+            node.prev = npos;
+            node.next = m_free;
+            m_free = index;
+        }
+
+        //delay 个刻度后的时间，溢出时取最大值（例如用 UINT64_MAX 表示永不触发）
+        uint64_t expireAfter(uint64_t delay)const noexcept
+        {
+            return delay > UINT64_MAX - m_now ? UINT64_MAX : m_now + delay;
+        }
+
+        //按到期时间放入对应层的槽中
+        void link(uint32_t index)noexcept
+        {
+            Node& node = m_nodes[index];
+            uint64_t expire = node.expire;
+            uint64_t delta = expire > m_now ? expire - m_now : 0;
+            constexpr uint64_t max_delta = (uint64_t(1) << (slot_bits * level_count)) - 1;
+            if (delta > max_delta)
+            {
+                //超出时间轮范围，先放在最高层，重新分配时再计算
+                expire = m_now + max_delta;
+                delta = max_delta;
+            }
+
+            uint32_t level = 0;
+            while (level + 1 < level_count && delta >= (uint64_t(1) << (slot_bits * (level + 1))))
+                level++;
+            const uint32_t slot = level * slot_count +
+                static_cast<uint32_t>((expire >> (slot_bits * level)) & (slot_count - 1));
+
+            node.slot = static_cast<uint16_t>(slot);
+            node.prev = npos;
+            node.next = m_heads[slot];
+            if (node.next != npos)
+                m_nodes[node.next].prev = index;
+            m_heads[slot] = index;
+        }
+        void unlink(uint32_t index)noexcept
+        {
+            Node& node = m_nodes[index];
+            if (node.prev != npos)
+                m_nodes[node.prev].next = node.next;
+            else
+                m_heads[node.slot] = node.next;
+            if (node.next != npos)
+                m_nodes[node.next].prev = node.prev;
+            node.prev = npos;
+            node.next = npos;
+        }
+
+        //下一层转完一圈时，把上一层当前槽中的定时器重新分配到下面的层
+        void cascade()noexcept
+        {
+            for (uint32_t level = 1; level < level_count; level++)
+            {
+                if (((m_now >> (slot_bits * (level - 1))) & (slot_count - 1)) != 0)
+                    break;
+                const uint32_t slot = level * slot_count +
+                    static_cast<uint32_t>((m_now >> (slot_bits * level)) & (slot_count - 1));
+                uint32_t index = m_heads[slot];
+                m_heads[slot] = npos;
+                while (index != npos)
+                {
+                    const uint32_t next = m_nodes[index].next;
+                    link(index);
+                    index = next;
+                }
+            }
+        }
+
+        size_t fireSlot(uint32_t slot)
+        {
+            size_t fired = 0;
+            //每次都从槽头取出一个节点，回调中对同一个槽的 Schedule 和 Cancel 不会影响遍历
+            while (m_heads[slot] != npos)
+            {
+                const uint32_t index = m_heads[slot];
+                unlink(index);
+                m_nodes[index].state = State::firing;
+                //回调抛出异常时也要重新放入时间轮或回收节点，否则节点会一直处于 firing 状态
+                Fire_guard guard{ *this, index };
+                //回调中可能会 Schedule 导致节点池扩容，因此先复制一份
+                const Callback callback = m_nodes[index].callback;
+                callback();
+                fired++;
+            }
+            return fired;
+        }
+        void finishNode(uint32_t index)noexcept
+        {
+            Node& node = m_nodes[index];
+            if (node.state == State::firing && node.period != 0)
+            {
+                node.state = State::pending;
+                node.expire = expireAfter(node.period);
+                link(index);
+            }
+            else
+            {
+                freeNode(index);
+                m_pending--;
+            }
+        }
+
+        struct Fire_guard
+        {
+            TimerWheel& wheel;
+            uint32_t index;
+            ~Fire_guard()
+            {
+                wheel.finishNode(index);
+            }
+        };
+
+        std::vector<Node> m_nodes;
+        uint32_t m_free = npos;
+        uint32_t m_heads[slot_count * level_count];
+        uint64_t m_now = 0;
+        size_t m_pending = 0;
+        Clock::duration m_tick;
+        Clock::time_point m_start;
+    };
+}